@@ -30,6 +30,15 @@ make -C core -j$THREADS
 make -C kernel_bench clean
 make -C kernel_bench all -j$THREADS
 
+make -C serial clean
+make -C serial all -j$THREADS
+
+make -C native clean
+make -C native all -j$THREADS
+
+make -C shmem clean
+make -C shmem all -j$THREADS
+
 
 if [[ $TASKBENCH_USE_MPI -eq 1 ]]; then
     make -C mpi clean
@@ -289,6 +298,12 @@ if [[ $USE_OPENMP -eq 1 ]]; then
     make -C openmp -j$THREADS
 fi
 
+# needs a C++20 compiler
+if [[ $USE_COROUTINE -eq 1 ]]; then
+    make -C coroutine clean
+    make -C coroutine -j$THREADS
+fi
+
 if [[ $USE_OMPSS -eq 1 ]]; then
     pushd "$NANOS_SRC_DIR"
     if [[ ! -d build ]]; then
@@ -14,6 +14,7 @@
  */
 
 #include <cassert>
+#include <climits>
 #include <cmath>
 #include <cstdio>
 #include <cstdlib>
@@ -21,7 +22,6 @@
 #include <atomic>
 #include <algorithm>
 #include <map>
-#include <set>
 #include <string>
 #include <math.h>
 
@@ -35,9 +35,470 @@ static std::atomic<TaskGraphMask> has_executed_graph;
 #endif
 
 static bool needs_period(DependenceType dtype) {
-  return dtype == DependenceType::SPREAD || dtype == DependenceType::RANDOM_NEAREST;
+  return dtype == DependenceType::SPREAD || dtype == DependenceType::RANDOM_NEAREST ||
+    dtype == DependenceType::POWER_LAW;
 }
 
+// Multigrid patterns run on levels 0 (finest, max_width points) through
+// levels-1 (coarsest, at least 1 point); each level halves the width of
+// the one above it.
+static long multigrid_levels(long max_width)
+{
+  long levels = 1;
+  while ((max_width >> levels) > 0) {
+    levels++;
+  }
+  return levels;
+}
+
+static long multigrid_cycle_length(DependenceType dtype, long levels)
+{
+  if (levels == 1) {
+    return 1;
+  }
+
+  switch (dtype) {
+  case DependenceType::V_CYCLE:
+    // 0, 1, ..., levels-1, ..., 1 (the next cycle starts back at 0)
+    return 2*(levels-1);
+  case DependenceType::W_CYCLE:
+    // See w_cycle_level below
+    return (1L << levels) - 2;
+  default:
+    assert(false && "unexpected dependence type");
+  };
+
+  return 0;
+}
+
+// A W-cycle starting from level visits level, then recursively runs
+// two W-cycles on level+1, then returns to level. Consecutive visits
+// to the same level are merged, so e.g. with three levels the cycle
+// is 0 1 2 1 2 1 0 and has 2^(coarsest-level+1)-1 steps.
+static long w_cycle_level(long level, long coarsest, long step)
+{
+  while (level < coarsest) {
+    long sub_length = (1L << (coarsest - level)) - 1;
+    if (step == 0 || step == 2*sub_length) {
+      return level;
+    }
+    // The second sub-cycle shares its first step with the end of the first.
+    step = step <= sub_length ? step - 1 : step - sub_length;
+    level++;
+  }
+  return level;
+}
+
+static long multigrid_level_at_timestep(const TaskGraph &g, long timestep)
+{
+  long levels = multigrid_levels(g.max_width);
+  long step = timestep % multigrid_cycle_length(g.dependence, levels);
+
+  switch (g.dependence) {
+  case DependenceType::V_CYCLE:
+    return step < levels ? step : 2*(levels-1) - step;
+  case DependenceType::W_CYCLE:
+    return w_cycle_level(0, levels-1, step);
+  default:
+    assert(false && "unexpected dependence type");
+  };
+
+  return 0;
+}
+
+// The wavefront pattern lays max_width out as one rows x cols grid,
+// with cols the largest divisor of max_width that is at most its
+// square root, and runs up to four sweeps over it, each from its own
+// corner (NW, SE, NE, SW in that order). Timestep t runs diagonal
+// t (mod rows+cols-1) of every sweep, measured from that sweep's
+// corner, so opposite sweeps meet in the middle and the others cross.
+// A cell on several sweeps' diagonals is a single task that reads the
+// upwind neighbors of each. The cells of a diagonal are numbered in
+// row-major order.
+struct Wavefront {
+  long sweeps;
+  long rows;
+  long cols;
+
+  Wavefront(const TaskGraph &g)
+    : sweeps(g.sweeps)
+  {
+    cols = 1;
+    for (long c = 1; c*c <= g.max_width; ++c) {
+      if (g.max_width % c == 0) {
+        cols = c;
+      }
+    }
+    rows = g.max_width / cols;
+  }
+
+  long diagonals() const { return rows + cols - 1; }
+
+  // Cell (row, col) in the frame of sweep, where diagonal d holds the
+  // cells with row + col == d. The frame is its own inverse.
+  void to_frame(long sweep, long &row, long &col) const
+  {
+    if (sweep == 1 || sweep == 3) row = rows - 1 - row;
+    if (sweep == 1 || sweep == 2) col = cols - 1 - col;
+  }
+
+  // Width of diagonal diag: distinct cells on the sweeps' lines.
+  long width(long diag) const { return count_before(diag, rows, 0); }
+
+  bool contains(long diag, long sweep, long row, long col) const
+  {
+    to_frame(sweep, row, col);
+    return row + col == diag;
+  }
+
+  bool contains(long diag, long row, long col) const
+  {
+    for (long sweep = 0; sweep < sweeps; ++sweep) {
+      if (contains(diag, sweep, row, col)) return true;
+    }
+    return false;
+  }
+
+  // Point of cell (row, col) on diagonal diag.
+  long point(long diag, long row, long col) const { return count_before(diag, row, col); }
+
+  // Cell of point on diagonal diag.
+  void cell(long diag, long point, long &row, long &col) const
+  {
+    // smallest cell id with point + 1 cells of the diagonal up to it
+    long lo = 0, hi = rows * cols - 1;
+    while (lo < hi) {
+      long mid = lo + (hi - lo) / 2;
+      if (count_before(diag, (mid + 1) / cols, (mid + 1) % cols) > point) {
+        hi = mid;
+      } else {
+        lo = mid + 1;
+      }
+    }
+    row = lo / cols;
+    col = lo % cols;
+  }
+
+  // Points across the step into diagonal diag that point depends on,
+  // or with reverse those that depend on it, as sorted intervals.
+  // Each sweep through the cell adds its upwind (downwind) neighbors;
+  // a sweep's starting corner and far corner link consecutive passes.
+  size_t edges(long diag, long point, bool reverse, std::pair<long, long> *deps) const
+  {
+    long last_diag = (diag + diagonals() - 1) % diagonals();
+    long from = reverse ? last_diag : diag;
+    long to = reverse ? diag : last_diag;
+    if (point < 0 || point >= width(from)) return 0;
+    long row, col;
+    cell(from, point, row, col);
+
+    long found[8];
+    long n = 0;
+    for (long sweep = 0; sweep < sweeps; ++sweep) {
+      if (!contains(from, sweep, row, col)) continue;
+      long candidates[2][2];
+      long num_candidates = 0;
+      if (diag == 0) {
+        long corner_row = reverse ? 0 : rows - 1;
+        long corner_col = reverse ? 0 : cols - 1;
+        candidates[num_candidates][0] = corner_row;
+        candidates[num_candidates++][1] = corner_col;
+      } else {
+        long r = row, c = col;
+        to_frame(sweep, r, c);
+        long step = reverse ? 1 : -1;
+        candidates[num_candidates][0] = r + step;
+        candidates[num_candidates++][1] = c;
+        candidates[num_candidates][0] = r;
+        candidates[num_candidates++][1] = c + step;
+      }
+      for (long i = 0; i < num_candidates; ++i) {
+        long r = candidates[i][0], c = candidates[i][1];
+        if (r < 0 || r >= rows || c < 0 || c >= cols) continue;
+        to_frame(sweep, r, c);
+        found[n++] = this->point(to, r, c);
+      }
+    }
+
+    std::sort(found, found + n);
+    size_t num_deps = 0;
+    for (long i = 0; i < n; ++i) {
+      if (num_deps > 0 && found[i] <= deps[num_deps-1].second + 1) {
+        deps[num_deps-1].second = std::max(deps[num_deps-1].second, found[i]);
+      } else {
+        deps[num_deps++] = std::pair<long, long>(found[i], found[i]);
+      }
+    }
+    return num_deps;
+  }
+
+private:
+  // Sweep lines are r + c == k (family 0) or r - c == k (family 1).
+  struct Line { int family; long k; };
+
+  long lines(long diag, Line *out) const
+  {
+    long n = 0;
+    for (long sweep = 0; sweep < sweeps; ++sweep) {
+      Line line;
+      switch (sweep) {
+      case 0: line = {0, diag}; break;
+      case 1: line = {0, rows + cols - 2 - diag}; break;
+      case 2: line = {1, diag - cols + 1}; break;
+      default: line = {1, rows - 1 - diag}; break;
+      }
+      bool duplicate = false;
+      for (long i = 0; i < n; ++i) {
+        duplicate = duplicate || (out[i].family == line.family && out[i].k == line.k);
+      }
+      if (!duplicate) out[n++] = line;
+    }
+    return n;
+  }
+
+  // Cells of line in rows [0, row) plus those of row in columns
+  // [0, col).
+  long count_line(const Line &line, long row, long col) const
+  {
+    long first, last;
+    if (line.family == 0) {
+      first = std::max(0L, line.k - cols + 1);
+      last = std::min(rows - 1, line.k);
+    } else {
+      first = std::max(0L, line.k);
+      last = std::min(rows - 1, cols - 1 + line.k);
+    }
+    if (first > last) return 0;
+    long count = std::max(0L, std::min(last + 1, row) - first);
+    if (row >= first && row <= last) {
+      long c = line.family == 0 ? line.k - row : row - line.k;
+      if (c < col) count++;
+    }
+    return count;
+  }
+
+  // Distinct cells of diagonal diag before cell (row, col) in
+  // row-major order. Distinct lines of one family never meet and lines
+  // of different families meet in at most one cell, so inclusion-
+  // exclusion stops at pairs.
+  long count_before(long diag, long row, long col) const
+  {
+    Line l[4];
+    long n = lines(diag, l);
+    long count = 0;
+    for (long i = 0; i < n; ++i) {
+      count += count_line(l[i], row, col);
+      for (long j = i + 1; j < n; ++j) {
+        if (l[i].family == l[j].family) continue;
+        long sum = l[i].family == 0 ? l[i].k : l[j].k;
+        long diff = l[i].family == 0 ? l[j].k : l[i].k;
+        if ((sum + diff) % 2 != 0) continue;
+        long r = (sum + diff) / 2, c = (sum - diff) / 2;
+        if (r < 0 || r >= rows || c < 0 || c >= cols) continue;
+        if (r < row || (r == row && c < col)) count--;
+      }
+    }
+    return count;
+  }
+};
+
+// Collective patterns (allreduce and scan) proceed in log-depth stages,
+// one per timestep. In every stage each point reads its own previous
+// value plus at most one partner.
+static long collective_stages(DependenceType dtype, long max_width)
+{
+  long k = (long)ceil(log2(max_width));
+  switch (dtype) {
+  case DependenceType::ALLREDUCE_BUTTERFLY:
+  case DependenceType::SCAN_HILLIS_STEELE:
+    return std::max(1L, k);
+  case DependenceType::ALLREDUCE_TREE:
+    // reduce to point 0, then broadcast back out
+    return std::max(1L, 2*k);
+  case DependenceType::SCAN_WORK_EFFICIENT:
+    // Brent-Kung up-sweep, then down-sweep
+    return std::max(1L, 2*k - 1);
+  default:
+    assert(false && "unexpected dependence type");
+  };
+
+  return 0;
+}
+
+// Returns the partner that point reads from in the given stage, or -1.
+static long collective_source(DependenceType dtype, long max_width, long stage, long point)
+{
+  long k = (long)ceil(log2(max_width));
+  if (k == 0) return -1;
+
+  long source = -1;
+  switch (dtype) {
+  case DependenceType::ALLREDUCE_BUTTERFLY:
+    source = point ^ (1L << stage);
+    break;
+  case DependenceType::ALLREDUCE_TREE:
+    if (stage < k) {
+      long d = 1L << stage;
+      if (point % (2*d) == 0) source = point + d;
+    } else {
+      long d = 1L << (2*k - 1 - stage);
+      if (point % (2*d) == d) source = point - d;
+    }
+    break;
+  case DependenceType::SCAN_HILLIS_STEELE:
+    source = point - (1L << stage);
+    break;
+  case DependenceType::SCAN_WORK_EFFICIENT:
+    if (stage < k) {
+      long d = 1L << stage;
+      if ((point + 1) % (2*d) == 0) source = point - d;
+    } else {
+      long d = 1L << (2*k - 2 - stage);
+      if ((point + 1) % (2*d) == d && point + 1 > 2*d) source = point - d;
+    }
+    break;
+  default:
+    assert(false && "unexpected dependence type");
+  };
+
+  if (source < 0 || source >= max_width) return -1;
+  return source;
+}
+
+// Returns the partner that reads from point in the given stage, or -1.
+static long collective_target(DependenceType dtype, long max_width, long stage, long point)
+{
+  long k = (long)ceil(log2(max_width));
+  if (k == 0) return -1;
+
+  long target;
+  switch (dtype) {
+  case DependenceType::ALLREDUCE_BUTTERFLY:
+    target = point ^ (1L << stage);
+    break;
+  case DependenceType::ALLREDUCE_TREE:
+    if (stage < k) {
+      target = point - (1L << stage);
+    } else {
+      target = point + (1L << (2*k - 1 - stage));
+    }
+    break;
+  case DependenceType::SCAN_HILLIS_STEELE:
+    target = point + (1L << stage);
+    break;
+  case DependenceType::SCAN_WORK_EFFICIENT:
+    if (stage < k) {
+      target = point + (1L << stage);
+    } else {
+      target = point + (1L << (2*k - 2 - stage));
+    }
+    break;
+  default:
+    assert(false && "unexpected dependence type");
+  };
+
+  if (target < 0 || target >= max_width) return -1;
+  if (collective_source(dtype, max_width, stage, target) != point) return -1;
+  return target;
+}
+
+// Writes point and partner (if any) as sorted, coalesced intervals.
+static size_t collective_intervals(long point, long partner, std::pair<long, long> *deps)
+{
+  if (partner < 0) {
+    deps[0] = std::pair<long, long>(point, point);
+    return 1;
+  }
+  long first = std::min(point, partner);
+  long last = std::max(point, partner);
+  if (last - first == 1) {
+    deps[0] = std::pair<long, long>(first, last);
+    return 1;
+  }
+  deps[0] = std::pair<long, long>(first, first);
+  deps[1] = std::pair<long, long>(last, last);
+  return 2;
+}
+
+// In the power-law pattern every point has an in-weight and an
+// out-weight drawn from a discrete Pareto distribution, P(weight >= k) ~
+// k^-(exponent-1), capped at radix. Producer q feeds consumer p when
+// 2*|p - q| < max(out-weight of q, in-weight of p), so high-weight points
+// become hubs with large fan-in or fan-out while every degree stays
+// bounded by radix.
+enum PowerLawRole {
+  POWER_LAW_IN = 0,
+  POWER_LAW_OUT = 1,
+};
+
+static long power_law_weight(const TaskGraph &g, long dset, long point, PowerLawRole role)
+{
+  const long hash_value[5] = {g.graph_index, g.radix, dset, point, role};
+  double value = random_uniform(&hash_value[0], sizeof(hash_value));
+  double weight = pow(1.0 - value, -1.0/(g.exponent - 1.0));
+  return (long)std::min(floor(weight), (double)g.radix);
+}
+
+// Enumerates the dependencies (or reverse dependencies) of point,
+// coalescing runs of adjacent points into intervals.
+static size_t power_law_edges(const TaskGraph &g, long dset, long point, bool reverse,
+                              std::pair<long, long> *deps)
+{
+  PowerLawRole own_role = reverse ? POWER_LAW_OUT : POWER_LAW_IN;
+  PowerLawRole other_role = reverse ? POWER_LAW_IN : POWER_LAW_OUT;
+  long own_weight = power_law_weight(g, dset, point, own_role);
+
+  size_t idx = 0;
+  long run_start = -1;
+  long i, last_i;
+  for (i = std::max(0L, point - (g.radix-1)/2),
+         last_i = std::min(point + (g.radix-1)/2, g.max_width-1);
+       i <= last_i; ++i) {
+    long distance = 2*std::abs(point - i);
+    bool include = distance < own_weight ||
+      distance < power_law_weight(g, dset, i, other_role);
+
+    if (include) {
+      if (run_start < 0) {
+        run_start = i;
+      }
+    } else {
+      if (run_start >= 0) {
+        deps[idx++] = std::pair<long, long>(run_start, i-1);
+      }
+      run_start = -1;
+    }
+  }
+  if (run_start >= 0) {
+    deps[idx++] = std::pair<long, long>(run_start, i-1);
+  }
+  return idx;
+}
+
+// A recursive graph repeats every 2*depth+1 timesteps; this returns the
+// position within the current repetition.
+static long recursive_step(const TaskGraph &g, long timestep)
+{
+  return timestep % (2*g.recursive_depth() + 1);
+}
+
+static bool executes_kernel(const TaskGraph &g, long timestep)
+{
+  if (g.dependence == DependenceType::RECURSIVE) {
+    // Only the leaves do real work; spawns and joins are empty tasks.
+    return recursive_step(g, timestep) == g.recursive_depth();
+  }
+  return true;
+}
+
+// Multigrid dependence sets are numbered 3*level + transition, where
+// the transition describes how the previous timestep relates to this one.
+enum MultigridTransition {
+  MULTIGRID_SMOOTH = 0, // same level: stencil within the level
+  MULTIGRID_RESTRICT = 1, // previous level was finer
+  MULTIGRID_PROLONG = 2, // previous level was coarser
+};
+
 void Kernel::execute(long graph_index, long timestep, long point,
                      char *scratch_ptr, size_t scratch_bytes) const
 {
@@ -122,6 +583,15 @@ static const std::map<std::string, DependenceType> dtype_by_name = {
   {"spread", DependenceType::SPREAD},
   {"random_nearest", DependenceType::RANDOM_NEAREST},
   {"random_spread", DependenceType::RANDOM_SPREAD},
+  {"v_cycle", DependenceType::V_CYCLE},
+  {"w_cycle", DependenceType::W_CYCLE},
+  {"wavefront", DependenceType::WAVEFRONT},
+  {"allreduce_butterfly", DependenceType::ALLREDUCE_BUTTERFLY},
+  {"allreduce_tree", DependenceType::ALLREDUCE_TREE},
+  {"scan_hillis_steele", DependenceType::SCAN_HILLIS_STEELE},
+  {"scan_work_efficient", DependenceType::SCAN_WORK_EFFICIENT},
+  {"power_law", DependenceType::POWER_LAW},
+  {"recursive", DependenceType::RECURSIVE},
 };
 
 static std::map<DependenceType, std::string> make_name_by_dtype()
@@ -140,6 +610,23 @@ static std::map<DependenceType, std::string> make_name_by_dtype()
 
 static std::map<DependenceType, std::string> name_by_dtype = make_name_by_dtype();
 
+static const std::map<std::string, OutputDistribution> odist_by_name = {
+  {"uniform", OutputDistribution::OUTPUT_UNIFORM},
+  {"point", OutputDistribution::OUTPUT_PER_POINT},
+  {"edge", OutputDistribution::OUTPUT_PER_EDGE},
+};
+
+static std::map<OutputDistribution, std::string> make_name_by_odist()
+{
+  std::map<OutputDistribution, std::string> names;
+  for (auto pair : odist_by_name) {
+    names[pair.second] = pair.first;
+  }
+  return names;
+}
+
+static const std::map<OutputDistribution, std::string> name_by_odist = make_name_by_odist();
+
 long TaskGraph::offset_at_timestep(long timestep) const
 {
   if (timestep < 0) {
@@ -161,6 +648,16 @@ long TaskGraph::offset_at_timestep(long timestep) const
   case DependenceType::SPREAD:
   case DependenceType::RANDOM_NEAREST:
   case DependenceType::RANDOM_SPREAD:
+  case DependenceType::V_CYCLE:
+  case DependenceType::W_CYCLE:
+    return 0;
+  case DependenceType::WAVEFRONT:
+  case DependenceType::ALLREDUCE_BUTTERFLY:
+  case DependenceType::ALLREDUCE_TREE:
+  case DependenceType::SCAN_HILLIS_STEELE:
+  case DependenceType::SCAN_WORK_EFFICIENT:
+  case DependenceType::POWER_LAW:
+  case DependenceType::RECURSIVE:
     return 0;
   default:
     assert(false && "unexpected dependence type");
@@ -191,6 +688,28 @@ long TaskGraph::width_at_timestep(long timestep) const
   case DependenceType::RANDOM_NEAREST:
   case DependenceType::RANDOM_SPREAD:
     return max_width;
+  case DependenceType::V_CYCLE:
+  case DependenceType::W_CYCLE:
+    return max_width >> multigrid_level_at_timestep(*this, timestep);
+  case DependenceType::WAVEFRONT:
+    {
+      Wavefront wf(*this);
+      return wf.width(timestep % wf.diagonals());
+    }
+  case DependenceType::ALLREDUCE_BUTTERFLY:
+  case DependenceType::ALLREDUCE_TREE:
+  case DependenceType::SCAN_HILLIS_STEELE:
+  case DependenceType::SCAN_WORK_EFFICIENT:
+  case DependenceType::POWER_LAW:
+    return max_width;
+  case DependenceType::RECURSIVE:
+    {
+      long width = 1;
+      for (long level = recursive_level(timestep); level > 0; --level) {
+        width *= radix;
+      }
+      return width;
+    }
   default:
     assert(false && "unexpected dependence type");
   };
@@ -214,7 +733,20 @@ long TaskGraph::max_dependence_sets() const
   case DependenceType::SPREAD:
   case DependenceType::RANDOM_NEAREST:
   case DependenceType::RANDOM_SPREAD:
+  case DependenceType::POWER_LAW:
     return period;
+  case DependenceType::V_CYCLE:
+  case DependenceType::W_CYCLE:
+    return 3*multigrid_levels(max_width);
+  case DependenceType::WAVEFRONT:
+    return Wavefront(*this).diagonals();
+  case DependenceType::ALLREDUCE_BUTTERFLY:
+  case DependenceType::ALLREDUCE_TREE:
+  case DependenceType::SCAN_HILLIS_STEELE:
+  case DependenceType::SCAN_WORK_EFFICIENT:
+    return collective_stages(dependence, max_width);
+  case DependenceType::RECURSIVE:
+    return 2*recursive_depth() + 1;
   default:
     assert(false && "unexpected dependence type");
   };
@@ -222,9 +754,15 @@ long TaskGraph::max_dependence_sets() const
 
 long TaskGraph::timestep_period() const
 {
-  // For all the dependence types currently defined, the pattern
-  // repeats with a period equal to the number of timesteps.
-  return max_dependence_sets();
+  switch (dependence) {
+  case DependenceType::V_CYCLE:
+  case DependenceType::W_CYCLE:
+    return multigrid_cycle_length(dependence, multigrid_levels(max_width));
+  default:
+    // For the remaining dependence types, the pattern repeats with a
+    // period equal to the number of dependence sets.
+    return max_dependence_sets();
+  };
 }
 
 long TaskGraph::dependence_set_at_timestep(long timestep) const
@@ -245,7 +783,30 @@ long TaskGraph::dependence_set_at_timestep(long timestep) const
   case DependenceType::SPREAD:
   case DependenceType::RANDOM_NEAREST:
   case DependenceType::RANDOM_SPREAD:
+  case DependenceType::POWER_LAW:
+    return timestep % max_dependence_sets();
+  case DependenceType::V_CYCLE:
+  case DependenceType::W_CYCLE:
+    {
+      long level = multigrid_level_at_timestep(*this, timestep);
+      long last_level = timestep > 0 ? multigrid_level_at_timestep(*this, timestep-1) : level;
+      if (last_level < level) {
+        return 3*level + MULTIGRID_RESTRICT;
+      } else if (last_level > level) {
+        return 3*level + MULTIGRID_PROLONG;
+      }
+      return 3*level + MULTIGRID_SMOOTH;
+    }
+  case DependenceType::WAVEFRONT:
     return timestep % max_dependence_sets();
+  case DependenceType::ALLREDUCE_BUTTERFLY:
+  case DependenceType::ALLREDUCE_TREE:
+  case DependenceType::SCAN_HILLIS_STEELE:
+  case DependenceType::SCAN_WORK_EFFICIENT:
+    // As with FFT, the first stage runs on the first timestep with inputs.
+    return (timestep + max_dependence_sets() - 1) % max_dependence_sets();
+  case DependenceType::RECURSIVE:
+    return recursive_step(*this, timestep);
   default:
     assert(false && "unexpected dependence type");
   };
@@ -364,6 +925,67 @@ size_t TaskGraph::reverse_dependencies(long dset, long point, std::pair<long, lo
       return idx;
     }
     break;
+  case DependenceType::V_CYCLE:
+  case DependenceType::W_CYCLE:
+    {
+      long level = dset / 3;
+      long width = max_width >> level;
+      long last_width, first, last;
+      switch (dset % 3) {
+      case MULTIGRID_SMOOTH:
+        last_width = width;
+        first = point - 1;
+        last = point + 1;
+        break;
+      case MULTIGRID_RESTRICT:
+        if (level == 0) return 0;
+        last_width = max_width >> (level-1);
+        first = (point - 1)/2;
+        last = (point + 1)/2;
+        break;
+      case MULTIGRID_PROLONG:
+        last_width = max_width >> (level+1);
+        first = 2*point - 1;
+        last = 2*point + 2;
+        break;
+      default:
+        assert(false && "unexpected multigrid transition");
+      }
+      if (point >= last_width) return 0;
+      first = std::max(0L, first);
+      last = std::min(last, width-1);
+      if (first > last) return 0;
+      deps[0] = std::pair<long, long>(first, last);
+      return 1;
+    }
+  case DependenceType::WAVEFRONT:
+    {
+      return Wavefront(*this).edges(dset, point, true, deps);
+    }
+  case DependenceType::ALLREDUCE_BUTTERFLY:
+  case DependenceType::ALLREDUCE_TREE:
+  case DependenceType::SCAN_HILLIS_STEELE:
+  case DependenceType::SCAN_WORK_EFFICIENT:
+    return collective_intervals(point, collective_target(dependence, max_width, dset, point), deps);
+  case DependenceType::POWER_LAW:
+    return power_law_edges(*this, dset, point, true, deps);
+  case DependenceType::RECURSIVE:
+    {
+      // dset is the step of the consumer; point is at the step before it.
+      long depth = recursive_depth();
+      long last_step = (dset + 2*depth) % (2*depth + 1);
+      long last_width = width_at_timestep(last_step);
+      if (point >= last_width) return 0;
+      if (dset == 0) {
+        // root join feeds the root of the next repetition
+        deps[0] = std::pair<long, long>(0, 0);
+      } else if (dset <= depth) {
+        deps[0] = recursive_children(point);
+      } else {
+        deps[0] = std::pair<long, long>(point / radix, point / radix);
+      }
+      return 1;
+    }
   default:
     assert(false && "unexpected dependence type");
   };
@@ -392,7 +1014,19 @@ size_t TaskGraph::num_reverse_dependencies(long dset, long point) const
     return radix > 0 ? 1 : 0;
   case DependenceType::SPREAD:
   case DependenceType::RANDOM_NEAREST:
+  case DependenceType::POWER_LAW:
     return radix;
+  case DependenceType::V_CYCLE:
+  case DependenceType::W_CYCLE:
+  case DependenceType::RECURSIVE:
+    return 1;
+  case DependenceType::WAVEFRONT:
+    return 2*sweeps;
+  case DependenceType::ALLREDUCE_BUTTERFLY:
+  case DependenceType::ALLREDUCE_TREE:
+  case DependenceType::SCAN_HILLIS_STEELE:
+  case DependenceType::SCAN_WORK_EFFICIENT:
+    return 2;
   default:
     assert(false && "unexpected dependence type");
   };
@@ -505,6 +1139,66 @@ size_t TaskGraph::dependencies(long dset, long point, std::pair<long, long> *dep
       return idx;
     }
     break;
+  case DependenceType::V_CYCLE:
+  case DependenceType::W_CYCLE:
+    {
+      long level = dset / 3;
+      long width = max_width >> level;
+      if (point >= width) return 0;
+      long last_width, first, last;
+      switch (dset % 3) {
+      case MULTIGRID_SMOOTH:
+        last_width = width;
+        first = point - 1;
+        last = point + 1;
+        break;
+      case MULTIGRID_RESTRICT:
+        if (level == 0) return 0;
+        last_width = max_width >> (level-1);
+        first = 2*point - 1;
+        last = 2*point + 2;
+        break;
+      case MULTIGRID_PROLONG:
+        last_width = max_width >> (level+1);
+        first = (point - 1)/2;
+        last = (point + 1)/2;
+        break;
+      default:
+        assert(false && "unexpected multigrid transition");
+      }
+      first = std::max(0L, first);
+      last = std::min(last, last_width-1);
+      if (first > last) return 0;
+      deps[0] = std::pair<long, long>(first, last);
+      return 1;
+    }
+  case DependenceType::WAVEFRONT:
+    {
+      return Wavefront(*this).edges(dset, point, false, deps);
+    }
+  case DependenceType::ALLREDUCE_BUTTERFLY:
+  case DependenceType::ALLREDUCE_TREE:
+  case DependenceType::SCAN_HILLIS_STEELE:
+  case DependenceType::SCAN_WORK_EFFICIENT:
+    return collective_intervals(point, collective_source(dependence, max_width, dset, point), deps);
+  case DependenceType::POWER_LAW:
+    return power_law_edges(*this, dset, point, false, deps);
+  case DependenceType::RECURSIVE:
+    {
+      long depth = recursive_depth();
+      if (point >= width_at_timestep(dset)) return 0;
+      if (dset == 0) {
+        // root reads the root join of the previous repetition
+        deps[0] = std::pair<long, long>(0, 0);
+      } else if (dset <= depth) {
+        // spawned by the parent
+        deps[0] = std::pair<long, long>(point / radix, point / radix);
+      } else {
+        // join reads its children
+        deps[0] = recursive_children(point);
+      }
+      return 1;
+    }
   default:
     assert(false && "unexpected dependence type");
   };
@@ -533,7 +1227,19 @@ size_t TaskGraph::num_dependencies(long dset, long point) const
     return radix > 0 ? 1 : 0;
   case DependenceType::SPREAD:
   case DependenceType::RANDOM_NEAREST:
+  case DependenceType::POWER_LAW:
     return radix;
+  case DependenceType::V_CYCLE:
+  case DependenceType::W_CYCLE:
+  case DependenceType::RECURSIVE:
+    return 1;
+  case DependenceType::WAVEFRONT:
+    return 2*sweeps;
+  case DependenceType::ALLREDUCE_BUTTERFLY:
+  case DependenceType::ALLREDUCE_TREE:
+  case DependenceType::SCAN_HILLIS_STEELE:
+  case DependenceType::SCAN_WORK_EFFICIENT:
+    return 2;
   default:
     assert(false && "unexpected dependence type");
   };
@@ -541,6 +1247,161 @@ size_t TaskGraph::num_dependencies(long dset, long point) const
   return SIZE_MAX;
 }
 
+// Calls fn(consumer) for every task at timestep+1 that reads the
+// output of (timestep, point), in the order reverse_dependencies() lists
+// them.
+template <typename F>
+static void for_each_consumer(const TaskGraph &g, long timestep, long point, F fn)
+{
+  if (timestep + 1 >= g.timesteps) {
+    return;
+  }
+
+  long offset = g.offset_at_timestep(timestep+1);
+  long width = g.width_at_timestep(timestep+1);
+  long dset = g.dependence_set_at_timestep(timestep+1);
+  size_t max_deps = g.num_reverse_dependencies(dset, point);
+  std::pair<long, long> *deps = reinterpret_cast<std::pair<long, long> *>(alloca(sizeof(std::pair<long, long>) * max_deps));
+  size_t num_deps = g.reverse_dependencies(dset, point, deps);
+  for (size_t span = 0; span < num_deps; span++) {
+    long first = std::max(deps[span].first, offset);
+    long last = std::min(deps[span].second, offset + width - 1);
+    for (long consumer = first; consumer <= last; consumer++) {
+      fn(consumer);
+    }
+  }
+}
+
+// Log-uniform sample between the minimum and maximum output size,
+// rounded down to a whole number of (timestep, point) pairs.
+static size_t sample_output_bytes(const TaskGraph &g, const long *hash_value, size_t hash_bytes)
+{
+  double value = random_uniform(hash_value, hash_bytes);
+  double lo = log((double)g.min_output_bytes_per_task);
+  double hi = log((double)g.output_bytes_per_task);
+  size_t bytes = (size_t)exp(lo + value*(hi - lo));
+  bytes = std::max(g.min_output_bytes_per_task, std::min(bytes, g.output_bytes_per_task));
+  bytes -= bytes % sizeof(std::pair<long, long>);
+  return std::max(bytes, sizeof(std::pair<long, long>));
+}
+
+size_t TaskGraph::output_field_bytes(long timestep, long point, long consumer) const
+{
+  switch (output_distribution) {
+  case OutputDistribution::OUTPUT_UNIFORM:
+    return output_bytes_per_task;
+  case OutputDistribution::OUTPUT_PER_POINT:
+    {
+      const long hash_value[2] = {graph_index, point};
+      return sample_output_bytes(*this, &hash_value[0], sizeof(hash_value));
+    }
+  case OutputDistribution::OUTPUT_PER_EDGE:
+    {
+      const long hash_value[3] = {graph_index, point, consumer};
+      return sample_output_bytes(*this, &hash_value[0], sizeof(hash_value));
+    }
+  default:
+    assert(false && "unexpected output distribution");
+  };
+
+  return 0;
+}
+
+size_t TaskGraph::output_field_offset(long timestep, long point, long consumer) const
+{
+  if (output_distribution != OutputDistribution::OUTPUT_PER_EDGE) {
+    return 0;
+  }
+
+  size_t offset = 0;
+  bool found = false;
+  for_each_consumer(*this, timestep, point, [&](long c) {
+    if (c == consumer) found = true;
+    if (!found) offset += output_field_bytes(timestep, point, c);
+  });
+  return offset;
+}
+
+size_t TaskGraph::task_output_bytes(long timestep, long point) const
+{
+  if (output_distribution != OutputDistribution::OUTPUT_PER_EDGE) {
+    return output_field_bytes(timestep, point, point);
+  }
+
+  size_t bytes = 0;
+  for_each_consumer(*this, timestep, point, [&](long c) {
+    bytes += output_field_bytes(timestep, point, c);
+  });
+  // A task with no consumers writes one field as if it were its own consumer.
+  if (bytes == 0) {
+    bytes = output_field_bytes(timestep, point, point);
+  }
+  return bytes;
+}
+
+size_t TaskGraph::max_output_bytes() const
+{
+  if (output_distribution != OutputDistribution::OUTPUT_PER_EDGE) {
+    return output_bytes_per_task;
+  }
+
+  long max_consumers = 1;
+  for (long dset = 0; dset < max_dependence_sets(); ++dset) {
+    for (long point = 0; point < max_width; ++point) {
+      long consumers = 0;
+      for (auto rdep : reverse_dependencies(dset, point)) {
+        consumers += rdep.second - rdep.first + 1;
+      }
+      max_consumers = std::max(max_consumers, consumers);
+    }
+  }
+  return max_consumers * output_bytes_per_task;
+}
+
+long TaskGraph::min_fields(long lookahead) const
+{
+  assert(lookahead >= 1);
+
+  // Every pattern reads only from the previous timestep. Unless a task
+  // reads nothing but its own point, that row must stay live while the
+  // lookahead rows are being written.
+  bool reads_others = dependence != DependenceType::TRIVIAL &&
+                      dependence != DependenceType::NO_COMM;
+  long fields = reads_others ? lookahead + 1 : lookahead;
+  return std::max(1L, std::min(fields, timesteps));
+}
+
+long TaskGraph::recursive_depth() const
+{
+  assert(dependence == DependenceType::RECURSIVE);
+  long depth = 0;
+  for (long leaves = radix; leaves <= max_width; leaves *= radix) {
+    depth++;
+  }
+  return depth;
+}
+
+long TaskGraph::recursive_level(long timestep) const
+{
+  long depth = recursive_depth();
+  long step = recursive_step(*this, timestep);
+  return step <= depth ? step : 2*depth - step;
+}
+
+std::pair<long, long> TaskGraph::recursive_children(long point) const
+{
+  assert(dependence == DependenceType::RECURSIVE);
+  return std::pair<long, long>(point*radix, point*radix + radix - 1);
+}
+
+long TaskGraph::recursive_join_timestep(long timestep) const
+{
+  long depth = recursive_depth();
+  long step = recursive_step(*this, timestep);
+  assert(step <= depth);
+  return timestep + 2*(depth - step);
+}
+
 #define MAGIC_VALUE UINT64_C(0x5C4A7C8B) // can you read it? it says "SCRATCHB" (kinda)
 
 void TaskGraph::execute_point(long timestep, long point,
@@ -577,7 +1438,7 @@ void TaskGraph::execute_point(long timestep, long point,
         if (last_offset <= dep && dep < last_offset + last_width) {
           assert(idx < n_inputs);
 
-          assert(input_bytes[idx] == output_bytes_per_task);
+          assert(input_bytes[idx] == output_field_bytes(timestep-1, dep, point));
           assert(input_bytes[idx] >= sizeof(std::pair<long, long>));
 
           const std::pair<long, long> *input = reinterpret_cast<const std::pair<long, long> *>(input_ptr[idx]);
@@ -603,7 +1464,7 @@ void TaskGraph::execute_point(long timestep, long point,
   }
 
   // Validate output
-  assert(output_bytes == output_bytes_per_task);
+  assert(output_bytes == task_output_bytes(timestep, point));
   assert(output_bytes >= sizeof(std::pair<long, long>));
 
   // Generate output
@@ -621,8 +1482,17 @@ void TaskGraph::execute_point(long timestep, long point,
   }
 
   // Execute kernel
-  Kernel k(kernel);
-  k.execute(graph_index, timestep, point, scratch_ptr, scratch_bytes);
+  if (executes_kernel(*this, timestep)) {
+    static_cast<const Kernel &>(kernel).execute(graph_index, timestep, point, scratch_ptr, scratch_bytes);
+  }
+}
+
+void TaskGraph::execute_point(long timestep, long point, const TaskArgs &args) const
+{
+  assert(args.n_inputs <= TaskArgs::MAX_INPUTS);
+  execute_point(timestep, point, args.output_ptr, args.output_bytes,
+                const_cast<const char **>(args.input_ptr), args.input_bytes, args.n_inputs,
+                args.scratch_ptr, args.scratch_bytes);
 }
 
 void TaskGraph::prepare_scratch(char *scratch_ptr, size_t scratch_bytes)
@@ -634,6 +1504,41 @@ void TaskGraph::prepare_scratch(char *scratch_ptr, size_t scratch_bytes)
   }
 }
 
+static std::vector<TaskGraph> registered_graphs;
+
+void register_task_graph(const TaskGraph &graph)
+{
+  assert(graph.graph_index >= 0);
+  // Every task of a registered graph must fit in a TaskDescriptor.
+  if (graph.timesteps - 1 > TASK_DESCRIPTOR_MAX_TIMESTEP || graph.graph_index > TASK_DESCRIPTOR_MAX_GRAPH_ID) {
+    fprintf(stderr, "error: Task graph %ld is too large to register\n", graph.graph_index);
+    abort();
+  }
+  size_t index = static_cast<size_t>(graph.graph_index);
+  if (index >= registered_graphs.size()) {
+    registered_graphs.resize(index + 1);
+  }
+  registered_graphs[index] = graph;
+}
+
+const TaskGraph &registered_task_graph(long graph_id)
+{
+  assert(graph_id >= 0);
+  size_t index = static_cast<size_t>(graph_id);
+  assert(index < registered_graphs.size());
+  return registered_graphs[index];
+}
+
+void execute_point(long graph_id, long timestep, long point, const TaskArgs &args)
+{
+  registered_task_graph(graph_id).execute_point(timestep, point, args);
+}
+
+void execute_point(const TaskDescriptor &task, const TaskArgs &args)
+{
+  execute_point(task.graph_id, task.timestep, task.point, args);
+}
+
 static TaskGraph default_graph(long graph_index)
 {
   TaskGraph graph;
@@ -645,8 +1550,12 @@ static TaskGraph default_graph(long graph_index)
   graph.radix = 3;
   graph.period = -1;
   graph.fraction_connected = 0.25;
+  graph.sweeps = 1;
+  graph.exponent = 2.0;
   graph.kernel = {KernelType::EMPTY, 0, 16, 0.0};
   graph.output_bytes_per_task = sizeof(std::pair<long, long>);
+  graph.output_distribution = OutputDistribution::OUTPUT_UNIFORM;
+  graph.min_output_bytes_per_task = sizeof(std::pair<long, long>);
   graph.scratch_bytes_per_task = 0;
   graph.nb_fields = 0;
   
@@ -666,11 +1575,15 @@ static void needs_argument(int i, int argc, const char *flag) {
 #define RADIX_FLAG "-radix"
 #define PERIOD_FLAG "-period"
 #define FRACTION_FLAG "-fraction"
+#define SWEEPS_FLAG "-sweeps"
+#define EXPONENT_FLAG "-exponent"
 #define AND_FLAG "-and"
 
 #define KERNEL_FLAG "-kernel"
 #define ITER_FLAG "-iter"
 #define OUTPUT_FLAG "-output"
+#define OUTPUT_DIST_FLAG "-output-dist"
+#define OUTPUT_MIN_FLAG "-output-min"
 #define SCRATCH_FLAG "-scratch"
 #define SAMPLE_FLAG "-sample"
 #define IMBALANCE_FLAG "-imbalance"
@@ -678,6 +1591,25 @@ static void needs_argument(int i, int argc, const char *flag) {
 #define NODES_FLAG "-nodes"
 #define SKIP_GRAPH_VALIDATION_FLAG "-skip-graph-validation"
 #define FIELD_FLAG "-field"
+#define FIELD_LOOKAHEAD_FLAG "-field-lookahead"
+#define PLACEMENT_FLAG "-placement"
+#define HUGE_PAGES_FLAG "-huge-pages"
+#define TENANT_FLAG "-tenant"
+#define PIN_FLAG "-pin"
+
+static const std::map<std::string, ArenaPlacement> placement_by_name = {
+  {"none", PLACEMENT_NONE},
+  {"first_touch", PLACEMENT_FIRST_TOUCH},
+  {"interleave", PLACEMENT_INTERLEAVE},
+};
+
+static const std::map<std::string, PinPolicy> pin_policy_by_name = {
+  {"none", PIN_NONE},
+  {"compact", PIN_COMPACT},
+  {"scatter", PIN_SCATTER},
+  {"core", PIN_CORE},
+  {"socket", PIN_SOCKET},
+};
 
 static void show_help_message(int argc, char **argv) {
   printf("%s: A Task Benchmark\n", argc > 0 ? argv[0] : "task_bench");
@@ -687,20 +1619,28 @@ static void show_help_message(int argc, char **argv) {
   printf("  %-18s number of nodes to use for estimating transfer statistics\n", NODES_FLAG);
   printf("  %-18s enable verbose output\n", "-v");
   printf("  %-18s enable extra verbose output\n", "-vv");
+  printf("  %-18s memory placement for driver buffers (none, first_touch, or interleave)\n", PLACEMENT_FLAG " [POLICY]");
+  printf("  %-18s back large driver buffers with transparent huge pages\n", HUGE_PAGES_FLAG);
+  printf("  %-18s thread pinning (none, compact, scatter, core, socket, or a CPU list like 0-3,8)\n", PIN_FLAG " [POLICY]");
+  printf("  %-18s start the options of another App sharing the same workers\n", TENANT_FLAG);
 
   printf("\nOptions for configuring the task graph:\n");
   printf("  %-18s height of task graph\n", STEPS_FLAG " [INT]");
   printf("  %-18s width of task graph\n", WIDTH_FLAG " [INT]");
   printf("  %-18s dependency pattern (see available list below)\n", TYPE_FLAG " [DEP]");
-  printf("  %-18s radix of dependency pattern (only for nearest, spread, and random)\n", RADIX_FLAG " [INT]");
-  printf("  %-18s period of dependency pattern (only for spread and random)\n", PERIOD_FLAG " [INT]");
+  printf("  %-18s radix of dependency pattern (only for nearest, spread, random, power_law, and recursive)\n", RADIX_FLAG " [INT]");
+  printf("  %-18s period of dependency pattern (only for spread, random, and power_law)\n", PERIOD_FLAG " [INT]");
   printf("  %-18s fraction of connected dependencies (only for random)\n", FRACTION_FLAG " [FLOAT]");
+  printf("  %-18s number of simultaneous sweep directions (only for wavefront)\n", SWEEPS_FLAG " [INT]");
+  printf("  %-18s exponent of degree distribution (only for power_law)\n", EXPONENT_FLAG " [FLOAT]");
   printf("  %-18s start configuring next task graph\n", AND_FLAG);
 
   printf("\nOptions for configuring kernels:\n");
   printf("  %-18s kernel type (see available list below)\n", KERNEL_FLAG " [KERNEL]");
   printf("  %-18s number of iterations\n", ITER_FLAG " [INT]");
-  printf("  %-18s output bytes per task\n", OUTPUT_FLAG " [INT]");
+  printf("  %-18s output bytes per task (maximum for non-uniform distributions)\n", OUTPUT_FLAG " [INT]");
+  printf("  %-18s output size distribution (uniform, point, or edge)\n", OUTPUT_DIST_FLAG " [DIST]");
+  printf("  %-18s minimum output bytes per task (only for non-uniform distributions)\n", OUTPUT_MIN_FLAG " [INT]");
   printf("  %-18s scratch bytes per task (only for memory-bound kernel)\n", SCRATCH_FLAG " [INT]");
   printf("  %-18s number of samples (only for memory-bound kernel)\n", SAMPLE_FLAG " [INT]");
   printf("  %-18s amount of load imbalance\n", IMBALANCE_FLAG " [FLOAT]");
@@ -717,18 +1657,28 @@ static void show_help_message(int argc, char **argv) {
 
   printf("\nLess frequently used options:\n");
   printf("  %-18s number of fields (optimization for certain task bench implementations)\n", FIELD_FLAG " [INT]");
+  printf("  %-18s timesteps that may run concurrently in drivers that default to the fewest fields\n", FIELD_LOOKAHEAD_FLAG " [INT]");
   printf("  %-18s skip task graph validation\n", SKIP_GRAPH_VALIDATION_FLAG);
 }
 
-App::App(int argc, char **argv)
+App::App(int argc, char **argv, long first_graph_index)
   : nodes(0)
   , verbose(0)
   , enable_graph_validation(true)
+  , placement(PLACEMENT_FIRST_TOUCH)
+  , huge_pages(false)
+  , pin_policy(PIN_NONE)
+  , field_lookahead(1)
 {
-  TaskGraph graph = default_graph(graphs.size());
+  TaskGraph graph = default_graph(first_graph_index);
 
   // Parse command line
   for (int i = 1; i < argc; i++) {
+    // The rest belongs to other Apps (see tenant_args).
+    if (!strcmp(argv[i], TENANT_FLAG)) {
+      break;
+    }
+
     if (!strcmp(argv[i], "-h")) {
       show_help_message(argc, argv);
       exit(0);
@@ -756,6 +1706,36 @@ App::App(int argc, char **argv)
       enable_graph_validation = false;
     }
 
+    if (!strcmp(argv[i], PLACEMENT_FLAG)) {
+      needs_argument(i, argc, PLACEMENT_FLAG);
+      auto name = argv[++i];
+      auto policy = placement_by_name.find(name);
+      if (policy == placement_by_name.end()) {
+        fprintf(stderr, "error: Invalid flag \"" PLACEMENT_FLAG " %s\"\n", name);
+        abort();
+      }
+      placement = policy->second;
+    }
+
+    if (!strcmp(argv[i], HUGE_PAGES_FLAG)) {
+      huge_pages = true;
+    }
+
+    if (!strcmp(argv[i], PIN_FLAG)) {
+      needs_argument(i, argc, PIN_FLAG);
+      auto name = argv[++i];
+      auto policy = pin_policy_by_name.find(name);
+      pin_cpus.clear();
+      if (policy != pin_policy_by_name.end()) {
+        pin_policy = policy->second;
+      } else if (parse_cpu_list(name, pin_cpus)) {
+        pin_policy = PIN_LIST;
+      } else {
+        fprintf(stderr, "error: Invalid flag \"" PIN_FLAG " %s\"\n", name);
+        abort();
+      }
+    }
+
     if (!strcmp(argv[i], STEPS_FLAG)) {
       needs_argument(i, argc, STEPS_FLAG);
       long value = atol(argv[++i]);
@@ -817,6 +1797,26 @@ App::App(int argc, char **argv)
       graph.fraction_connected = value;
     }
 
+    if (!strcmp(argv[i], SWEEPS_FLAG)) {
+      needs_argument(i, argc, SWEEPS_FLAG);
+      long value = atol(argv[++i]);
+      if (value < 1 || value > 4) {
+        fprintf(stderr, "error: Invalid flag \"" SWEEPS_FLAG " %ld\" must be >= 1 and <= 4\n", value);
+        abort();
+      }
+      graph.sweeps = value;
+    }
+
+    if (!strcmp(argv[i], EXPONENT_FLAG)) {
+      needs_argument(i, argc, EXPONENT_FLAG);
+      double value = atof(argv[++i]);
+      if (value <= 1) {
+        fprintf(stderr, "error: Invalid flag \"" EXPONENT_FLAG " %f\" must be > 1\n", value);
+        abort();
+      }
+      graph.exponent = value;
+    }
+
     if (!strcmp(argv[i], KERNEL_FLAG)) {
       needs_argument(i, argc, KERNEL_FLAG);
       auto name = argv[++i];
@@ -841,7 +1841,7 @@ App::App(int argc, char **argv)
     if (!strcmp(argv[i], OUTPUT_FLAG)) {
       needs_argument(i, argc, OUTPUT_FLAG);
       long value  = atol(argv[++i]);
-      if (value < sizeof(std::pair<long, long>)) {
+      if (value < (long)sizeof(std::pair<long, long>)) {
         fprintf(stderr, "error: Invalid flag \"" OUTPUT_FLAG " %ld\" must be >= %lu\n",
                 value, sizeof(std::pair<long, long>));
         abort();
@@ -849,6 +1849,28 @@ App::App(int argc, char **argv)
       graph.output_bytes_per_task = value;
     }
 
+    if (!strcmp(argv[i], OUTPUT_DIST_FLAG)) {
+      needs_argument(i, argc, OUTPUT_DIST_FLAG);
+      auto name = argv[++i];
+      auto dist = odist_by_name.find(name);
+      if (dist == odist_by_name.end()) {
+        fprintf(stderr, "error: Invalid flag \"" OUTPUT_DIST_FLAG " %s\"\n", name);
+        abort();
+      }
+      graph.output_distribution = dist->second;
+    }
+
+    if (!strcmp(argv[i], OUTPUT_MIN_FLAG)) {
+      needs_argument(i, argc, OUTPUT_MIN_FLAG);
+      long value  = atol(argv[++i]);
+      if (value < (long)sizeof(std::pair<long, long>)) {
+        fprintf(stderr, "error: Invalid flag \"" OUTPUT_MIN_FLAG " %ld\" must be >= %lu\n",
+                value, sizeof(std::pair<long, long>));
+        abort();
+      }
+      graph.min_output_bytes_per_task = value;
+    }
+
     if (!strcmp(argv[i], SCRATCH_FLAG)) {
       needs_argument(i, argc, SCRATCH_FLAG);
       long value  = atol(argv[++i]);
@@ -889,13 +1911,23 @@ App::App(int argc, char **argv)
       graph.nb_fields = value;
     }
 
+    if (!strcmp(argv[i], FIELD_LOOKAHEAD_FLAG)) {
+      needs_argument(i, argc, FIELD_LOOKAHEAD_FLAG);
+      long value = atol(argv[++i]);
+      if (value <= 0) {
+        fprintf(stderr, "error: Invalid flag \"" FIELD_LOOKAHEAD_FLAG " %ld\" must be > 0\n", value);
+        abort();
+      }
+      field_lookahead = value;
+    }
+
     if (!strcmp(argv[i], AND_FLAG)) {
       // Hack: set default value of period for random graph
       if (graph.period < 0) {
         graph.period = needs_period(graph.dependence) ? 3 : 0;
       }
       graphs.push_back(graph);
-      graph = default_graph(graphs.size());
+      graph = default_graph(first_graph_index + graphs.size());
     }
   }
 
@@ -908,12 +1940,30 @@ App::App(int argc, char **argv)
   // check nb_fields, if not set by user, set it to timesteps
   for (int j = 0; j < graphs.size(); j++) {
     TaskGraph &g = graphs[j];
+    default_fields.push_back(g.nb_fields == 0);
     if (g.nb_fields == 0) {
       g.nb_fields = g.timesteps;
     }
   }
   
   check();
+
+  for (auto &g : graphs) {
+    register_task_graph(g);
+  }
+}
+
+std::vector<std::vector<char *> > tenant_args(int argc, char **argv)
+{
+  std::vector<std::vector<char *> > tenants;
+  for (int i = 1; i < argc; i++) {
+    if (!strcmp(argv[i], TENANT_FLAG)) {
+      tenants.push_back(std::vector<char *>(1, argv[0]));
+    } else if (!tenants.empty()) {
+      tenants.back().push_back(argv[i]);
+    }
+  }
+  return tenants;
 }
 
 void App::check() const
@@ -945,6 +1995,38 @@ void App::check() const
       abort();
     }
 
+    if (g.output_distribution != OutputDistribution::OUTPUT_UNIFORM &&
+        g.min_output_bytes_per_task > g.output_bytes_per_task) {
+      fprintf(stderr, "error: Minimum output bytes (specify with " OUTPUT_MIN_FLAG ") must be at most output bytes (specify with " OUTPUT_FLAG ")\n");
+      abort();
+    }
+
+    if (g.dependence == DependenceType::RECURSIVE && g.radix < 2) {
+      fprintf(stderr, "error: Graph type \"%s\" requires a radix (branching factor) of at least 2\n",
+              name_by_dtype.at(g.dependence).c_str());
+      abort();
+    }
+
+    // A prime width would only factor as a 1-wide grid, a serial chain.
+    if (g.dependence == DependenceType::WAVEFRONT && Wavefront(g).cols < 2) {
+      fprintf(stderr, "error: Graph type \"%s\" requires a width that factors into a grid at least 2 cells wide (got %ld)\n",
+              name_by_dtype.at(g.dependence).c_str(), g.max_width);
+      abort();
+    }
+
+    // Drivers number tasks as timestep * width + point.
+    long num_tasks;
+    if (__builtin_mul_overflow(g.timesteps, g.max_width, &num_tasks)) {
+      fprintf(stderr, "error: Task graph of %ld timesteps by %ld points has too many tasks\n",
+              g.timesteps, g.max_width);
+      abort();
+    }
+    if (g.timesteps - 1 > TASK_DESCRIPTOR_MAX_TIMESTEP) {
+      fprintf(stderr, "error: Task graph of %ld timesteps exceeds the limit of %ld\n",
+              g.timesteps, TASK_DESCRIPTOR_MAX_TIMESTEP + 1);
+      abort();
+    }
+
     for (long t = 0; t < g.timesteps; ++t) {
       long offset = g.offset_at_timestep(t);
       long width = g.width_at_timestep(t);
@@ -956,14 +2038,17 @@ void App::check() const
       assert(dset >= 0 && dset <= g.max_dependence_sets());
     }
     for (long dset = 0; dset < g.max_dependence_sets(); ++dset) {
-      std::map<long, std::set<long> > materialized_deps;
+      // Kept as sorted intervals rather than points, so that dense
+      // patterns such as all_to_all need O(width) memory to check.
+      std::vector<std::vector<std::pair<long, long> > > sorted_deps(g.max_width);
       for (long point = 0; point < g.max_width; ++point) {
-        auto deps = g.dependencies(dset, point);
-        for (auto dep : deps) {
-          for (long dp = dep.first; dp <= dep.second; ++dp) {
-            assert(materialized_deps[point].count(dp) == 0); // No duplicates
-            materialized_deps[point].insert(dp);
-          }
+        auto &deps = sorted_deps[point];
+        for (auto dep : g.dependencies(dset, point)) {
+          if (dep.first <= dep.second) deps.push_back(dep);
+        }
+        std::sort(deps.begin(), deps.end());
+        for (size_t i = 1; i < deps.size(); ++i) {
+          assert(deps[i-1].second < deps[i].first); // No duplicates
         }
       }
 
@@ -972,7 +2057,10 @@ void App::check() const
         auto rdeps = g.reverse_dependencies(dset, point);
         for (auto rdep : rdeps) {
           for (long rdp = rdep.first; rdp <= rdep.second; ++rdp) {
-            assert(materialized_deps[rdp].count(point) == 1);
+            assert(0 <= rdp && rdp < g.max_width);
+            const auto &deps = sorted_deps[rdp];
+            auto it = std::upper_bound(deps.begin(), deps.end(), std::make_pair(point, LONG_MAX));
+            assert(it != deps.begin() && (it-1)->second >= point);
           }
         }
       }
@@ -980,6 +2068,16 @@ void App::check() const
   }
 }
 
+void App::use_min_fields()
+{
+  for (size_t j = 0; j < graphs.size(); j++) {
+    if (!default_fields[j]) continue;
+    TaskGraph &g = graphs[j];
+    g.nb_fields = g.min_fields(field_lookahead);
+    register_task_graph(g);
+  }
+}
+
 void App::display() const
 {
   printf("Running Task Benchmark\n");
@@ -995,13 +2093,20 @@ void App::display() const
     printf("      Radix: %ld\n", g.radix);
     printf("      Period: %ld\n", g.period);
     printf("      Fraction Connected: %f\n", g.fraction_connected);
+    printf("      Sweeps: %ld\n", g.sweeps);
+    printf("      Exponent: %f\n", g.exponent);
     printf("      Kernel:\n");
     printf("        Type: %s\n", name_by_ktype.at(g.kernel.type).c_str());
     printf("        Iterations: %ld\n", g.kernel.iterations);
     printf("        Samples: %d\n", g.kernel.samples);
     printf("        Imbalance: %f\n", g.kernel.imbalance);
     printf("      Output Bytes: %lu\n", g.output_bytes_per_task);
+    printf("      Output Distribution: %s\n", name_by_odist.at(g.output_distribution).c_str());
+    if (g.output_distribution != OutputDistribution::OUTPUT_UNIFORM) {
+      printf("      Min Output Bytes: %lu\n", g.min_output_bytes_per_task);
+    }
     printf("      Scratch Bytes: %lu\n", g.scratch_bytes_per_task);
+    printf("      Fields: %d\n", g.nb_fields);
 
     if (verbose > 0) {
       for (long t = 0; t < g.timesteps; ++t) {
@@ -1057,6 +2162,10 @@ void App::display() const
 // IMPORTANT: Keep this up-to-date with kernel implementations
 long long count_flops_per_task(const TaskGraph &g, long timestep, long point)
 {
+  if (!executes_kernel(g, timestep)) {
+    return 0;
+  }
+
   switch(g.kernel.type) {
   case KernelType::EMPTY:
   case KernelType::BUSY_WAIT:
@@ -1095,6 +2204,10 @@ long long count_flops_per_task(const TaskGraph &g, long timestep, long point)
 // IMPORTANT: Keep this up-to-date with kernel implementations
 long long count_bytes_per_task(const TaskGraph &g, long timestep, long point)
 {
+  if (!executes_kernel(g, timestep)) {
+    return 0;
+  }
+
   switch(g.kernel.type) {
   case KernelType::EMPTY:
   case KernelType::BUSY_WAIT:
@@ -1170,6 +2283,9 @@ void App::report_timing(double elapsed_seconds) const
     long long num_deps = 0;
     long long local_deps = 0;
     long long nonlocal_deps = 0;
+    long long local_bytes = 0;
+    long long nonlocal_bytes = 0;
+    bool uniform = g.output_distribution == OutputDistribution::OUTPUT_UNIFORM;
 #ifdef DEBUG_CORE
     if (enable_graph_validation) {
       assert((has_executed_graph.load() & (1 << g.graph_index)) != 0);
@@ -1207,6 +2323,17 @@ void App::report_timing(double elapsed_seconds) const
             nonlocal_deps += initial_last - initial_first + 1;
             local_deps += local_last - local_first + 1;
             nonlocal_deps += final_last - final_first + 1;
+
+            if (!uniform) {
+              for (long dp = dep_first; dp <= dep_last; ++dp) {
+                long long field_bytes = g.output_field_bytes(t-1, dp, p);
+                if (dp >= node_first && dp <= node_last) {
+                  local_bytes += field_bytes;
+                } else {
+                  nonlocal_bytes += field_bytes;
+                }
+              }
+            }
           }
         }
       }
@@ -1218,8 +2345,12 @@ void App::report_timing(double elapsed_seconds) const
     total_nonlocal_deps += nonlocal_deps;
     flops += count_flops(g);
     bytes += count_bytes(g);
-    local_transfer += local_deps * g.output_bytes_per_task;
-    nonlocal_transfer += nonlocal_deps * g.output_bytes_per_task;
+    if (uniform) {
+      local_bytes = local_deps * g.output_bytes_per_task;
+      nonlocal_bytes = nonlocal_deps * g.output_bytes_per_task;
+    }
+    local_transfer += local_bytes;
+    nonlocal_transfer += nonlocal_bytes;
   }
 
   printf("Total Tasks %lld\n", total_num_tasks);
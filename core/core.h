@@ -17,6 +17,11 @@
 #define CORE_H
 
 #include "core_c.h"
+#include "core_arena.h"
+#include "core_topology.h"
+
+#include <cassert>
+#include <cstdint>
 
 #include <string>
 #include <vector>
@@ -25,6 +30,8 @@ typedef dependence_type_t DependenceType;
 
 typedef kernel_type_t KernelType;
 
+typedef output_distribution_t OutputDistribution;
+
 struct TaskGraph;
 
 struct Kernel : public kernel_t {
@@ -37,6 +44,39 @@ private:
   friend struct TaskGraph;
 };
 
+// Inline description of a single task invocation, so that drivers can
+// call execute_point without building vectors on every task. Inputs
+// are stored in place up to MAX_INPUTS; tasks with more inputs than
+// that must use the pointer-based execute_point instead.
+struct TaskArgs {
+  static const size_t MAX_INPUTS = 64;
+
+  char *output_ptr;
+  size_t output_bytes;
+  char *scratch_ptr;
+  size_t scratch_bytes;
+  size_t n_inputs;
+  const char *input_ptr[MAX_INPUTS];
+  size_t input_bytes[MAX_INPUTS];
+
+  void reset(char *output, size_t output_size, char *scratch, size_t scratch_size)
+  {
+    output_ptr = output;
+    output_bytes = output_size;
+    scratch_ptr = scratch;
+    scratch_bytes = scratch_size;
+    n_inputs = 0;
+  }
+
+  void add_input(const char *ptr, size_t bytes)
+  {
+    assert(n_inputs < MAX_INPUTS);
+    input_ptr[n_inputs] = ptr;
+    input_bytes[n_inputs] = bytes;
+    n_inputs++;
+  }
+};
+
 struct TaskGraph : public task_graph_t {
   TaskGraph() = default;
   TaskGraph(task_graph_t t) : task_graph_t(t) {}
@@ -64,29 +104,106 @@ struct TaskGraph : public task_graph_t {
   size_t num_reverse_dependencies(long dset, long point) const;
   size_t num_dependencies(long dset, long point) const;
 
+  // Output layout. With the uniform distribution every task writes a
+  // single output_bytes_per_task buffer that all consumers read. With
+  // per-point sizes the single buffer varies in size by point. With
+  // per-edge sizes the output is split into one field per consumer, in
+  // the order reverse_dependencies() lists them, and each consumer
+  // receives only its own field as input. Drivers should size output
+  // buffers with max_output_bytes().
+  size_t task_output_bytes(long timestep, long point) const;
+  size_t max_output_bytes() const;
+  size_t output_field_bytes(long timestep, long point, long consumer) const;
+  size_t output_field_offset(long timestep, long point, long consumer) const;
+
+  // Number of output fields needed by a driver that stores the output
+  // of (timestep, point) in field timestep % nb_fields and lets up to
+  // lookahead consecutive timesteps run at once. A lookahead of 1 is
+  // the minimum needed for correctness.
+  long min_fields(long lookahead) const;
+
+  // Fork-join view of the recursive pattern, for runtimes that spawn
+  // tasks recursively rather than timestep by timestep. Each repetition
+  // spawns levels 0 through recursive_depth() at timesteps 0..depth,
+  // runs the kernel only at the leaves, and joins back up at timesteps
+  // depth+1..2*depth. A task at a spawning timestep forks the children
+  // returned by recursive_children(), and its matching join runs at
+  // recursive_join_timestep() once those children have joined.
+  long recursive_depth() const;
+  long recursive_level(long timestep) const;
+  std::pair<long, long> recursive_children(long point) const;
+  long recursive_join_timestep(long timestep) const;
+
   void execute_point(long timestep, long point,
                      char *output_ptr, size_t output_bytes,
                      const char **input_ptr, const size_t *input_bytes,
                      size_t n_inputs,
                      char *scratch_ptr, size_t scratch_bytes) const;
+  void execute_point(long timestep, long point, const TaskArgs &args) const;
   static void prepare_scratch(char *scratch_ptr, size_t scratch_bytes);
 };
 
+// Compact handle for a single task. Runtimes can store this in place
+// of a full TaskGraph and look the graph up in the registry at
+// execution time. Timesteps get the wider field since graphs of more
+// than 2^31 timesteps are far more likely than 2^15 graphs.
+#define TASK_DESCRIPTOR_MAX_TIMESTEP ((1L << 47) - 1)
+#define TASK_DESCRIPTOR_MAX_GRAPH_ID ((1L << 15) - 1)
+struct TaskDescriptor {
+  int64_t timestep : 48;
+  int64_t graph_id : 16; // TaskGraph::graph_index of a registered graph
+  int64_t point;
+};
+
+// Registry of task graphs indexed by graph_index. App registers its
+// graphs on construction. Registration is not thread-safe and must
+// complete before tasks execute; lookups may happen concurrently.
+void register_task_graph(const TaskGraph &graph);
+const TaskGraph &registered_task_graph(long graph_id);
+void execute_point(long graph_id, long timestep, long point, const TaskArgs &args);
+void execute_point(const TaskDescriptor &task, const TaskArgs &args);
+
 struct App {
   std::vector<TaskGraph> graphs;
   long nodes;
   int verbose;
   bool enable_graph_validation;
-
-  App(int argc, char **argv);
+  ArenaPlacement placement; // for buffers allocated by drivers
+  bool huge_pages;
+  PinPolicy pin_policy; // for threads started by drivers
+  std::vector<int> pin_cpus; // for PIN_LIST
+  long field_lookahead; // for use_min_fields
+  std::vector<bool> default_fields; // graphs that did not set -field
+
+  // Parses argv up to the first -tenant. Graph indices start at
+  // first_graph_index so that graphs of several Apps in one process
+  // stay distinct.
+  App(int argc, char **argv, long first_graph_index = 0);
   void check() const;
+  // Graphs without -field get one field per timestep. Drivers that
+  // keep outputs in a ring of fields call this before display() to
+  // use the fewest fields that allow -field-lookahead instead.
+  void use_min_fields();
   void display() const;
   void report_timing(double elapsed_seconds) const;
 };
 
-// Make sure core types are POD
-static_assert(std::is_pod<Kernel>::value, "Kernel must be POD");
-static_assert(std::is_pod<TaskGraph>::value, "TaskGraph must be POD");
+// Command lines of the Apps that follow each -tenant in argv, each
+// starting with argv[0]. Drivers that support tenants build one App
+// from each.
+std::vector<std::vector<char *> > tenant_args(int argc, char **argv);
+
+// Make sure core types are POD (spelled out because std::is_pod is
+// deprecated in C++20)
+#define CORE_IS_POD(T) (std::is_trivial<T>::value && std::is_standard_layout<T>::value)
+static_assert(CORE_IS_POD(Kernel), "Kernel must be POD");
+static_assert(CORE_IS_POD(TaskGraph), "TaskGraph must be POD");
+static_assert(CORE_IS_POD(TaskArgs), "TaskArgs must be POD");
+static_assert(CORE_IS_POD(TaskDescriptor), "TaskDescriptor must be POD");
+static_assert(sizeof(TaskDescriptor) == 16, "TaskDescriptor must be 16 bytes");
+// Timesteps, points and task counts are all long; graphs beyond 2^31
+// tasks need it to be 64 bits.
+static_assert(sizeof(long) == 8, "long must be 64 bits");
 
 long long count_flops_per_task(const TaskGraph &g, long timestep, long point);
 long long count_bytes_per_task(const TaskGraph &g, long timestep, long point);
@@ -0,0 +1,251 @@
+/* Copyright 2020 Stanford University
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <cassert>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+#include <sys/mman.h>
+#include <unistd.h>
+#ifdef __linux__
+#include <sys/syscall.h>
+#endif
+
+#include "core_arena.h"
+
+#define HUGE_PAGE_SIZE (2UL << 20)
+
+// From <linux/mempolicy.h>, to avoid a dependency on libnuma.
+#define ARENA_MPOL_INTERLEAVE 3
+
+static size_t round_up(size_t value, size_t multiple)
+{
+  return (value + multiple - 1) / multiple * multiple;
+}
+
+#ifdef __linux__
+// Reads /sys/devices/system/node/online (e.g. "0-1,3") into a bitmask.
+static unsigned long online_node_mask()
+{
+  unsigned long mask = 0;
+  FILE *f = fopen("/sys/devices/system/node/online", "r");
+  if (!f) {
+    return 1;
+  }
+  long first, last;
+  while (fscanf(f, "%ld", &first) == 1) {
+    last = first;
+    int c = fgetc(f);
+    if (c == '-') {
+      if (fscanf(f, "%ld", &last) != 1) break;
+      c = fgetc(f);
+    }
+    for (long node = first; node <= last && node < (long)sizeof(mask)*8; node++) {
+      mask |= 1UL << node;
+    }
+    if (c != ',') break;
+  }
+  fclose(f);
+  return mask ? mask : 1;
+}
+#endif
+
+size_t checked_mul(size_t a, size_t b, const char *what)
+{
+  size_t product;
+  if (__builtin_mul_overflow(a, b, &product)) {
+    fprintf(stderr, "error: Size of %s overflows (%zu * %zu)\n", what, a, b);
+    abort();
+  }
+  return product;
+}
+
+Arena::Arena()
+  : base(NULL)
+  , count(0)
+  , stride(0)
+  , mapping(NULL)
+  , mapping_bytes(0)
+{
+}
+
+Arena::~Arena()
+{
+  release();
+}
+
+void Arena::allocate(size_t num_blocks, size_t block_bytes,
+                     ArenaPlacement placement, bool huge_pages)
+{
+  release();
+
+  count = num_blocks;
+  stride = round_up(block_bytes > 0 ? block_bytes : 1, CACHE_LINE_SIZE);
+  size_t bytes = round_up(checked_mul(count, stride, "arena"), sysconf(_SC_PAGESIZE));
+  if (bytes == 0) {
+    return;
+  }
+
+  // Over-allocate so that the usable region can start on a huge page
+  // boundary, otherwise the kernel can only back its interior.
+  huge_pages = huge_pages && bytes >= HUGE_PAGE_SIZE;
+  if (huge_pages) {
+    bytes = round_up(bytes, HUGE_PAGE_SIZE);
+  }
+  mapping_bytes = bytes + (huge_pages ? HUGE_PAGE_SIZE : 0);
+  void *ptr = mmap(NULL, mapping_bytes, PROT_READ | PROT_WRITE,
+                   MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+  if (ptr == MAP_FAILED) {
+    fprintf(stderr, "error: Unable to allocate arena of %lu bytes\n", mapping_bytes);
+    abort();
+  }
+  mapping = reinterpret_cast<char *>(ptr);
+  base = mapping;
+  if (huge_pages) {
+    base = reinterpret_cast<char *>(round_up(reinterpret_cast<size_t>(mapping), HUGE_PAGE_SIZE));
+#ifdef MADV_HUGEPAGE
+    madvise(base, bytes, MADV_HUGEPAGE);
+#endif
+  }
+
+#ifdef __linux__
+  if (placement == PLACEMENT_INTERLEAVE) {
+    // Placement is only a hint: ignore failures (e.g. when mbind is
+    // not permitted in a container).
+    unsigned long mask = online_node_mask();
+    syscall(SYS_mbind, base, bytes, ARENA_MPOL_INTERLEAVE, &mask, sizeof(mask)*8, 0);
+  }
+#endif
+
+  if (placement == PLACEMENT_NONE) {
+    touch(0, count);
+  }
+}
+
+void Arena::release()
+{
+  if (mapping) {
+    munmap(mapping, mapping_bytes);
+  }
+  base = NULL;
+  count = 0;
+  stride = 0;
+  mapping = NULL;
+  mapping_bytes = 0;
+}
+
+void Arena::touch(size_t first, size_t num) const
+{
+  assert(first + num <= count);
+  if (num > 0) {
+    memset(block(first), 0, num * stride);
+  }
+}
+
+ScratchPool::ScratchPool()
+  : bytes(0)
+  , threads(0)
+  , head(0)
+{
+}
+
+void ScratchPool::allocate(int num_threads, size_t buffer_bytes,
+                           ArenaPlacement placement, bool huge_pages)
+{
+  assert(num_threads > 0);
+  threads = num_threads;
+  bytes = buffer_bytes;
+  buffers.allocate(2 * threads, bytes, placement, huge_pages);
+  caches.allocate(threads, sizeof(char *), PLACEMENT_NONE, false);
+  std::vector<std::atomic<uint32_t> > links(2 * threads);
+  next.swap(links);
+
+  // Buffer t starts in thread t's cache, buffer threads + t on the stack.
+  for (int t = 0; t < threads; t++) {
+    cache(t) = buffers.block(t);
+  }
+  head.store(0, std::memory_order_relaxed);
+  for (int t = threads; t > 0; t--) {
+    push(threads + t - 1);
+  }
+}
+
+void ScratchPool::touch(int thread, void (*prepare)(char *buffer, size_t bytes))
+{
+  assert(0 <= thread && thread < threads);
+  for (size_t index : {size_t(thread), size_t(threads + thread)}) {
+    buffers.touch(index, 1);
+    if (prepare) {
+      prepare(buffers.block(index), bytes);
+    }
+  }
+}
+
+char *ScratchPool::acquire(int thread)
+{
+  assert(0 <= thread && thread < threads);
+  char *&cached = cache(thread);
+  if (cached) {
+    char *buffer = cached;
+    cached = NULL;
+    return buffer;
+  }
+
+  // At most threads - 1 buffers are in other caches and at most
+  // threads - 1 are in use, so the stack cannot be empty.
+  uint32_t index;
+  bool found = pop(index);
+  assert(found);
+  (void)found;
+  return buffers.block(index);
+}
+
+void ScratchPool::release(int thread, char *buffer)
+{
+  assert(0 <= thread && thread < threads);
+  char *&cached = cache(thread);
+  if (!cached) {
+    cached = buffer;
+    return;
+  }
+  push((buffer - buffers.block(0)) / buffers.block_stride());
+}
+
+void ScratchPool::push(uint32_t index)
+{
+  uint64_t old = head.load(std::memory_order_relaxed);
+  uint64_t desired;
+  do {
+    next[index].store(uint32_t(old), std::memory_order_relaxed);
+    desired = ((old >> 32) + 1) << 32 | (index + 1);
+  } while (!head.compare_exchange_weak(old, desired, std::memory_order_release,
+                                       std::memory_order_relaxed));
+}
+
+bool ScratchPool::pop(uint32_t &index)
+{
+  uint64_t old = head.load(std::memory_order_acquire);
+  uint64_t desired;
+  do {
+    if (uint32_t(old) == 0) {
+      return false;
+    }
+    index = uint32_t(old) - 1;
+    desired = ((old >> 32) + 1) << 32 | next[index].load(std::memory_order_relaxed);
+  } while (!head.compare_exchange_weak(old, desired, std::memory_order_acquire,
+                                       std::memory_order_acquire));
+  return true;
+}
@@ -0,0 +1,114 @@
+/* Copyright 2020 Stanford University
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef CORE_ARENA_H
+#define CORE_ARENA_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#define CACHE_LINE_SIZE 64
+
+enum ArenaPlacement {
+  PLACEMENT_NONE, // pages land wherever the allocating thread touches them
+  PLACEMENT_FIRST_TOUCH, // each block is touched first by the thread that owns it
+  PLACEMENT_INTERLEAVE, // pages are interleaved across all NUMA nodes
+};
+
+// a * b for buffer sizes; fails with an error naming what instead of
+// wrapping around when the product does not fit in size_t.
+size_t checked_mul(size_t a, size_t b, const char *what);
+
+// A single allocation split into equally sized blocks, each padded to
+// a whole number of cache lines so that blocks owned by different
+// workers never share a line. Memory comes straight from mmap and is
+// not touched on allocation, so with PLACEMENT_FIRST_TOUCH the caller
+// should call touch() for each block from the thread that will use it.
+struct Arena {
+  Arena();
+  ~Arena();
+
+  void allocate(size_t num_blocks, size_t block_bytes,
+                ArenaPlacement placement, bool huge_pages);
+  void release();
+
+  char *block(size_t index) const { return base + index * stride; }
+  size_t num_blocks() const { return count; }
+  size_t block_stride() const { return stride; }
+
+  // Zeroes blocks [first, first + num) from the calling thread.
+  void touch(size_t first, size_t num) const;
+
+private:
+  Arena(const Arena &) = delete;
+  Arena &operator=(const Arena &) = delete;
+
+  char *base;
+  size_t count;
+  size_t stride;
+  char *mapping;
+  size_t mapping_bytes;
+};
+
+// Fixed set of scratch buffers handed out to whichever task runs next,
+// for runtimes where a task may start on one thread and finish on
+// another (e.g. untied OpenMP tasks), so that per-thread buffers are
+// not safe. There are two buffers per thread. Each thread caches one
+// buffer and the rest sit on a lock-free stack, so a thread never
+// waits as long as each thread holds at most one buffer at a time.
+//
+// thread must identify the calling thread (e.g. omp_get_thread_num())
+// and may differ between acquire() and release().
+struct ScratchPool {
+  ScratchPool();
+
+  void allocate(int num_threads, size_t buffer_bytes,
+                ArenaPlacement placement, bool huge_pages);
+
+  // Touches the buffers that start out in this thread's cache and on
+  // the stack on its behalf, and runs prepare on each. Must be called
+  // by every thread before the first acquire().
+  void touch(int thread, void (*prepare)(char *buffer, size_t bytes) = NULL);
+
+  char *acquire(int thread);
+  void release(int thread, char *buffer);
+
+  size_t buffer_bytes() const { return bytes; }
+
+private:
+  ScratchPool(const ScratchPool &) = delete;
+  ScratchPool &operator=(const ScratchPool &) = delete;
+
+  // Stack of buffer indices; head packs (tag << 32) | (index + 1) so
+  // that a pop racing with a pop and push of the same index fails.
+  void push(uint32_t index);
+  bool pop(uint32_t &index);
+
+  // One cache line per thread, holding its cached buffer or NULL.
+  char *&cache(int thread) { return *reinterpret_cast<char **>(caches.block(thread)); }
+
+  Arena buffers;
+  Arena caches;
+  size_t bytes;
+  int threads;
+  std::vector<std::atomic<uint32_t> > next;
+  char pad0[CACHE_LINE_SIZE];
+  std::atomic<uint64_t> head;
+  char pad1[CACHE_LINE_SIZE];
+};
+
+#endif
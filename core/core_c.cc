@@ -154,6 +154,54 @@ void task_graph_prepare_scratch(char *scratch_ptr, size_t scratch_bytes)
   TaskGraph::prepare_scratch(scratch_ptr, scratch_bytes);
 }
 
+size_t task_graph_task_output_bytes(task_graph_t graph, long timestep, long point)
+{
+  TaskGraph t(graph);
+  return t.task_output_bytes(timestep, point);
+}
+
+size_t task_graph_max_output_bytes(task_graph_t graph)
+{
+  TaskGraph t(graph);
+  return t.max_output_bytes();
+}
+
+size_t task_graph_output_field_bytes(task_graph_t graph, long timestep, long point, long consumer)
+{
+  TaskGraph t(graph);
+  return t.output_field_bytes(timestep, point, consumer);
+}
+
+size_t task_graph_output_field_offset(task_graph_t graph, long timestep, long point, long consumer)
+{
+  TaskGraph t(graph);
+  return t.output_field_offset(timestep, point, consumer);
+}
+
+long task_graph_recursive_depth(task_graph_t graph)
+{
+  TaskGraph t(graph);
+  return t.recursive_depth();
+}
+
+long task_graph_recursive_level(task_graph_t graph, long timestep)
+{
+  TaskGraph t(graph);
+  return t.recursive_level(timestep);
+}
+
+interval_t task_graph_recursive_children(task_graph_t graph, long point)
+{
+  TaskGraph t(graph);
+  return wrap(t.recursive_children(point));
+}
+
+long task_graph_recursive_join_timestep(task_graph_t graph, long timestep)
+{
+  TaskGraph t(graph);
+  return t.recursive_join_timestep(timestep);
+}
+
 void interval_list_destroy(interval_list_t intervals)
 {
   std::vector<std::pair<long, long> > *i = unwrap(intervals);
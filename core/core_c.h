@@ -37,6 +37,15 @@ typedef enum dependence_type_t {
   SPREAD,
   RANDOM_NEAREST,
   RANDOM_SPREAD,
+  V_CYCLE,
+  W_CYCLE,
+  WAVEFRONT,
+  ALLREDUCE_BUTTERFLY,
+  ALLREDUCE_TREE,
+  SCAN_HILLIS_STEELE,
+  SCAN_WORK_EFFICIENT,
+  POWER_LAW,
+  RECURSIVE,
 } dependence_type_t;
 
 typedef enum kernel_type_t {
@@ -51,6 +60,12 @@ typedef enum kernel_type_t {
   LOAD_IMBALANCE,
 } kernel_type_t;
 
+typedef enum output_distribution_t {
+  OUTPUT_UNIFORM, // every task writes output_bytes_per_task, read by all consumers
+  OUTPUT_PER_POINT, // size varies per point, read by all consumers
+  OUTPUT_PER_EDGE, // one field per consumer, size varies per edge
+} output_distribution_t;
+
 typedef struct kernel_t {
   kernel_type_t type;
   long iterations;
@@ -80,8 +95,12 @@ typedef struct task_graph_t {
   long radix; // max number of dependencies in nearest/spread/random patterns
   long period; // period of repetition in spread/random pattern
   double fraction_connected; // fraction of connected nodes in random pattern
+  long sweeps; // number of simultaneous sweep directions in wavefront pattern
+  double exponent; // exponent of degree distribution in power-law pattern
   kernel_t kernel;
-  size_t output_bytes_per_task;
+  size_t output_bytes_per_task; // maximum for non-uniform distributions
+  output_distribution_t output_distribution;
+  size_t min_output_bytes_per_task; // only for non-uniform distributions
   size_t scratch_bytes_per_task;
   int nb_fields;
 } task_graph_t;
@@ -117,6 +136,14 @@ void task_graph_execute_point_scratch_nonconst(task_graph_t graph, long timestep
                                                size_t n_inputs,
                                                char *scratch_ptr, size_t scratch_bytes);
 void task_graph_prepare_scratch(char *scratch_ptr, size_t scratch_bytes);
+size_t task_graph_task_output_bytes(task_graph_t graph, long timestep, long point);
+size_t task_graph_max_output_bytes(task_graph_t graph);
+size_t task_graph_output_field_bytes(task_graph_t graph, long timestep, long point, long consumer);
+size_t task_graph_output_field_offset(task_graph_t graph, long timestep, long point, long consumer);
+long task_graph_recursive_depth(task_graph_t graph);
+long task_graph_recursive_level(task_graph_t graph, long timestep);
+interval_t task_graph_recursive_children(task_graph_t graph, long point);
+long task_graph_recursive_join_timestep(task_graph_t graph, long timestep);
 
 typedef struct task_graph_list_t {
   void *impl;
@@ -0,0 +1,1279 @@
+/* Copyright 2020 Stanford University
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <cassert>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <algorithm>
+#include <new>
+
+#include <sched.h>
+#ifdef __linux__
+#include <linux/futex.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+#include "core_executor.h"
+#include "timer.h"
+
+#define INITIAL_DEQUE_CAPACITY 1024
+#define SPINS_BEFORE_YIELD 64
+
+struct WorkerStart {
+  WorkerPool *pool;
+  int worker;
+};
+
+WorkerPool::WorkerPool(int workers, const ThreadPinning *pinning)
+  : num_workers(workers)
+  , pinning(pinning)
+  , generation(0)
+  , pending(0)
+  , shutdown(false)
+  , job(NULL)
+  , job_arg(NULL)
+{
+  assert(workers > 0);
+  pthread_mutex_init(&lock, NULL);
+  pthread_cond_init(&wake, NULL);
+  pthread_cond_init(&finished, NULL);
+
+  if (pinning) {
+    pinning->pin(0);
+  }
+
+  threads.resize(num_workers - 1);
+  for (int worker = 1; worker < num_workers; worker++) {
+    WorkerStart *start = new WorkerStart;
+    start->pool = this;
+    start->worker = worker;
+    int rc = pthread_create(&threads[worker - 1], NULL, thread_main, start);
+    if (rc != 0) {
+      fprintf(stderr, "error: Unable to create worker thread (error %d)\n", rc);
+      abort();
+    }
+  }
+}
+
+WorkerPool::~WorkerPool()
+{
+  pthread_mutex_lock(&lock);
+  shutdown = true;
+  pthread_cond_broadcast(&wake);
+  pthread_mutex_unlock(&lock);
+
+  for (auto thread : threads) {
+    pthread_join(thread, NULL);
+  }
+
+  pthread_cond_destroy(&finished);
+  pthread_cond_destroy(&wake);
+  pthread_mutex_destroy(&lock);
+}
+
+void *WorkerPool::thread_main(void *arg)
+{
+  WorkerStart *start = reinterpret_cast<WorkerStart *>(arg);
+  WorkerPool *pool = start->pool;
+  int worker = start->worker;
+  delete start;
+
+  pool->worker_main(worker);
+  return NULL;
+}
+
+void WorkerPool::worker_main(int worker)
+{
+  if (pinning) {
+    pinning->pin(worker);
+  }
+
+  long seen = 0;
+  while (true) {
+    pthread_mutex_lock(&lock);
+    while (generation == seen && !shutdown) {
+      pthread_cond_wait(&wake, &lock);
+    }
+    if (shutdown) {
+      pthread_mutex_unlock(&lock);
+      return;
+    }
+    seen = generation;
+    void (*fn)(int, void *) = job;
+    void *arg = job_arg;
+    pthread_mutex_unlock(&lock);
+
+    fn(worker, arg);
+
+    pthread_mutex_lock(&lock);
+    if (--pending == 0) {
+      pthread_cond_signal(&finished);
+    }
+    pthread_mutex_unlock(&lock);
+  }
+}
+
+void WorkerPool::run(void (*fn)(int worker, void *arg), void *arg)
+{
+  pthread_mutex_lock(&lock);
+  job = fn;
+  job_arg = arg;
+  pending = num_workers - 1;
+  generation++;
+  pthread_cond_broadcast(&wake);
+  pthread_mutex_unlock(&lock);
+
+  fn(0, arg);
+
+  pthread_mutex_lock(&lock);
+  while (pending > 0) {
+    pthread_cond_wait(&finished, &lock);
+  }
+  pthread_mutex_unlock(&lock);
+}
+
+// Chase-Lev work-stealing deque (Le et al., "Correct and Efficient
+// Work-Stealing for Weak Memory Models", PPoPP 2013). The owner pushes
+// and pops at the bottom, thieves steal from the top. The buffer grows
+// when full; old buffers are retired until the deque is destroyed
+// because a thief may still be reading them.
+struct TaskDeque {
+  struct Buffer {
+    int64_t capacity;
+    std::atomic<int64_t> *slots;
+
+    explicit Buffer(int64_t capacity)
+      : capacity(capacity)
+      , slots(new std::atomic<int64_t>[capacity])
+    {
+    }
+    ~Buffer() { delete [] slots; }
+
+    int64_t get(int64_t i) const { return slots[i & (capacity - 1)].load(std::memory_order_relaxed); }
+    void put(int64_t i, int64_t value) { slots[i & (capacity - 1)].store(value, std::memory_order_relaxed); }
+  };
+
+  alignas(CACHE_LINE_SIZE) std::atomic<int64_t> top;
+  alignas(CACHE_LINE_SIZE) std::atomic<int64_t> bottom;
+  std::atomic<Buffer *> buffer;
+  std::vector<Buffer *> retired;
+
+  TaskDeque()
+    : top(0)
+    , bottom(0)
+    , buffer(new Buffer(INITIAL_DEQUE_CAPACITY))
+  {
+  }
+
+  ~TaskDeque()
+  {
+    delete buffer.load();
+    for (auto old : retired) {
+      delete old;
+    }
+  }
+
+  void push(int64_t task)
+  {
+    int64_t b = bottom.load(std::memory_order_relaxed);
+    int64_t t = top.load(std::memory_order_acquire);
+    Buffer *a = buffer.load(std::memory_order_relaxed);
+    if (b - t > a->capacity - 1) {
+      Buffer *grown = new Buffer(a->capacity * 2);
+      for (int64_t i = t; i < b; i++) {
+        grown->put(i, a->get(i));
+      }
+      retired.push_back(a);
+      buffer.store(grown, std::memory_order_release);
+      a = grown;
+    }
+    a->put(b, task);
+    std::atomic_thread_fence(std::memory_order_release);
+    bottom.store(b + 1, std::memory_order_relaxed);
+  }
+
+  bool pop(int64_t &task)
+  {
+    int64_t b = bottom.load(std::memory_order_relaxed) - 1;
+    Buffer *a = buffer.load(std::memory_order_relaxed);
+    bottom.store(b, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    int64_t t = top.load(std::memory_order_relaxed);
+    if (t > b) {
+      bottom.store(b + 1, std::memory_order_relaxed);
+      return false;
+    }
+    task = a->get(b);
+    if (t == b) {
+      bool won = top.compare_exchange_strong(t, t + 1, std::memory_order_seq_cst,
+                                             std::memory_order_relaxed);
+      bottom.store(b + 1, std::memory_order_relaxed);
+      return won;
+    }
+    return true;
+  }
+
+  bool steal(int64_t &task)
+  {
+    int64_t t = top.load(std::memory_order_acquire);
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    int64_t b = bottom.load(std::memory_order_acquire);
+    if (t >= b) {
+      return false;
+    }
+    Buffer *a = buffer.load(std::memory_order_acquire);
+    task = a->get(t);
+    return top.compare_exchange_strong(t, t + 1, std::memory_order_seq_cst,
+                                       std::memory_order_relaxed);
+  }
+};
+
+// Per-worker state, padded so that workers never share a cache line.
+struct alignas(CACHE_LINE_SIZE) DataflowWorker {
+  TaskDeque deque;
+  std::vector<const char *> input_ptr;
+  std::vector<size_t> input_bytes;
+  char *scratch_ptr;
+  uint64_t rng;
+};
+
+ElasticWorkers::Schedule ElasticWorkers::parse_schedule(const char *spec, int workers)
+{
+  Schedule schedule;
+  const char *p = spec;
+  while (*p) {
+    char *end = NULL;
+    long timestep = strtol(p, &end, 10);
+    if (end == p || *end != ':') break;
+    p = end + 1;
+    long count = strtol(p, &end, 10);
+    if (end == p) break;
+    p = end;
+    if (timestep < 0 || (!schedule.empty() && timestep <= schedule.back().first) ||
+        count < 1 || count > workers) {
+      fprintf(stderr, "error: Invalid elastic schedule \"%s\": timesteps must increase and counts be between 1 and %d\n",
+              spec, workers);
+      abort();
+    }
+    schedule.push_back(std::make_pair(timestep, (int)count));
+    if (*p == ',') p++;
+  }
+  if (*p || schedule.empty()) {
+    fprintf(stderr, "error: Invalid elastic schedule \"%s\", expected T:N[,T:N...]\n", spec);
+    abort();
+  }
+  return schedule;
+}
+
+static void futex_wait(std::atomic<int> *addr, int expected)
+{
+#ifdef __linux__
+  syscall(SYS_futex, reinterpret_cast<int *>(addr), FUTEX_WAIT_PRIVATE, expected, NULL, NULL, 0);
+#else
+  sched_yield();
+#endif
+}
+
+static void futex_wake(std::atomic<int> *addr)
+{
+#ifdef __linux__
+  syscall(SYS_futex, reinterpret_cast<int *>(addr), FUTEX_WAKE_PRIVATE, INT32_MAX, NULL, NULL, 0);
+#endif
+}
+
+ElasticWorkers::ElasticWorkers(int workers, const Schedule &schedule, long timesteps)
+  : workers(workers)
+  , schedule(schedule)
+  , reached_at(timesteps, 0.0)
+  , next_step(0)
+  , progress(-1)
+  , active(workers)
+{
+  pthread_mutex_init(&step_lock, NULL);
+  reset();
+}
+
+ElasticWorkers::~ElasticWorkers()
+{
+  pthread_mutex_destroy(&step_lock);
+}
+
+void ElasticWorkers::reset()
+{
+  std::fill(reached_at.begin(), reached_at.end(), 0.0);
+  next_step.store(0, std::memory_order_relaxed);
+  progress.store(-1, std::memory_order_relaxed);
+  active.store(workers, std::memory_order_release);
+}
+
+void ElasticWorkers::reached(long timestep)
+{
+  // Fast path: a relaxed load of a line that only changes once per
+  // timestep.
+  long seen = progress.load(std::memory_order_relaxed);
+  while (seen < timestep) {
+    if (progress.compare_exchange_weak(seen, timestep, std::memory_order_acq_rel)) {
+      break;
+    }
+  }
+  if (seen >= timestep) {
+    // Another worker got there first; it records the timings.
+    return;
+  }
+  double now = Timer::get_cur_time();
+  for (long t = seen + 1; t <= timestep; t++) {
+    reached_at[t] = now;
+  }
+
+  // Winners own disjoint ranges of timesteps, so every step has one
+  // winner that sees it due. Steps are applied under a lock up to the
+  // latest progress, so an older count never overwrites a newer one.
+  long step = next_step.load(std::memory_order_relaxed);
+  if (step >= (long)schedule.size() || schedule[step].first > timestep) {
+    return;
+  }
+  pthread_mutex_lock(&step_lock);
+  long latest = progress.load(std::memory_order_acquire);
+  step = next_step.load(std::memory_order_relaxed);
+  long last = step;
+  while (last < (long)schedule.size() && schedule[last].first <= latest) {
+    last++;
+  }
+  if (last > step) {
+    next_step.store(last, std::memory_order_relaxed);
+    int count = schedule[last - 1].second;
+    int before = active.exchange(count, std::memory_order_acq_rel);
+    if (count > before) {
+      futex_wake(&active);
+    }
+  }
+  pthread_mutex_unlock(&step_lock);
+}
+
+void ElasticWorkers::park_if_inactive(int worker)
+{
+  int count = active.load(std::memory_order_acquire);
+  while (worker >= count) {
+    futex_wait(&active, count);
+    count = active.load(std::memory_order_acquire);
+  }
+}
+
+int ElasticWorkers::workers_at(long timestep) const
+{
+  int count = workers;
+  for (auto &step : schedule) {
+    if (step.first > timestep) break;
+    count = step.second;
+  }
+  return count;
+}
+
+void ElasticWorkers::release()
+{
+  active.store(workers, std::memory_order_release);
+  futex_wake(&active);
+}
+
+void ElasticWorkers::report(const std::vector<TaskGraph> &graphs) const
+{
+  long timesteps = reached_at.size();
+  long last = std::min(progress.load(std::memory_order_acquire), timesteps - 1);
+
+  // Rate of timestep t, measured between its start and the next one's.
+  std::vector<double> rate(timesteps, 0.0);
+  for (long t = 0; t < last; t++) {
+    long tasks = 0;
+    for (auto &g : graphs) {
+      if (t < g.timesteps) tasks += g.width_at_timestep(t);
+    }
+    double seconds = reached_at[t + 1] - reached_at[t];
+    rate[t] = seconds > 0 ? tasks / seconds : 0.0;
+  }
+
+  for (size_t phase = 0; phase < schedule.size(); phase++) {
+    long first = schedule[phase].first;
+    long end = phase + 1 < schedule.size() ? schedule[phase + 1].first : last;
+    end = std::min(end, last);
+    if (first >= end) continue;
+
+    // Steady state: the second half of the phase.
+    long half = first + (end - first) / 2;
+    long tasks = 0;
+    for (long t = half; t < end; t++) {
+      for (auto &g : graphs) {
+        if (t < g.timesteps) tasks += g.width_at_timestep(t);
+      }
+    }
+    double seconds = reached_at[end] - reached_at[half];
+    double steady = seconds > 0 ? tasks / seconds : 0.0;
+
+    // Settled once a timestep runs within 20% of the steady rate.
+    long settled = first;
+    while (settled < end && std::abs(rate[settled] - steady) > 0.2 * steady) {
+      settled++;
+    }
+    printf("Elastic phase %zu: %d workers from timestep %ld, %e tasks/s steady, ",
+           phase, schedule[phase].second, first, steady);
+    if (settled < end) {
+      printf("settled after %ld timesteps (%e seconds)\n",
+             settled - first, reached_at[settled] - reached_at[first]);
+    } else {
+      printf("did not settle\n");
+    }
+  }
+}
+
+GraphIndex::GraphIndex(const TaskGraph &graph)
+  : timesteps(graph.timesteps)
+  , width(graph.max_width)
+  , row_offset(timesteps)
+  , row_width(timesteps)
+  , row_dset(timesteps)
+  , max_inputs(0)
+{
+  for (long t = 0; t < timesteps; t++) {
+    row_offset[t] = graph.offset_at_timestep(t);
+    row_width[t] = graph.width_at_timestep(t);
+    row_dset[t] = graph.dependence_set_at_timestep(t);
+  }
+
+  long dsets = graph.max_dependence_sets();
+  dep_start.reserve(dsets * width + 1);
+  dep_start.push_back(0);
+  for (long dset = 0; dset < dsets; dset++) {
+    for (long point = 0; point < width; point++) {
+      size_t num_deps = 0;
+      for (auto interval : graph.dependencies(dset, point)) {
+        dep_spans.push_back(interval);
+        num_deps += interval.second - interval.first + 1;
+      }
+      max_inputs = std::max(max_inputs, num_deps);
+      dep_start.push_back(dep_spans.size());
+    }
+  }
+
+  // Reverse index derived from the forward one so that the two agree
+  // exactly. Consumers are visited in increasing order, so each one
+  // either extends the last interval of a producer or starts a new one.
+  rdep_start.reserve(dsets * width + 1);
+  rdep_start.push_back(0);
+  std::vector<std::vector<std::pair<long, long> > > consumers(width);
+  for (long dset = 0; dset < dsets; dset++) {
+    for (long point = 0; point < width; point++) {
+      size_t idx = dset * width + point;
+      for (size_t i = dep_start[idx]; i < dep_start[idx + 1]; i++) {
+        for (long dep = dep_spans[i].first; dep <= dep_spans[i].second; dep++) {
+          std::vector<std::pair<long, long> > &spans = consumers[dep];
+          if (!spans.empty() && spans.back().second == point - 1) {
+            spans.back().second = point;
+          } else {
+            spans.push_back(std::pair<long, long>(point, point));
+          }
+        }
+      }
+    }
+    for (long point = 0; point < width; point++) {
+      rdep_spans.insert(rdep_spans.end(), consumers[point].begin(), consumers[point].end());
+      rdep_start.push_back(rdep_spans.size());
+      consumers[point].clear();
+    }
+  }
+}
+
+size_t GraphIndex::num_inputs(long timestep, long point) const
+{
+  if (timestep == 0) return 0;
+  size_t count = 0;
+  size_t idx = dep_index(timestep, point);
+  for (size_t i = dep_start[idx]; i < dep_start[idx + 1]; i++) {
+    std::pair<long, long> deps = clip(timestep - 1, dep_spans[i]);
+    if (deps.first <= deps.second) count += deps.second - deps.first + 1;
+  }
+  return count;
+}
+
+size_t GraphIndex::num_consumers(long timestep, long point) const
+{
+  if (timestep + 1 >= timesteps) return 0;
+  size_t count = 0;
+  size_t ridx = dep_index(timestep + 1, point);
+  for (size_t i = rdep_start[ridx]; i < rdep_start[ridx + 1]; i++) {
+    std::pair<long, long> consumers = clip(timestep + 1, rdep_spans[i]);
+    if (consumers.first <= consumers.second) count += consumers.second - consumers.first + 1;
+  }
+  return count;
+}
+
+// One graph of a DataflowExecutor. Its tasks are numbered first_task +
+// t * width + point, so that tasks of all graphs share one id space.
+struct DataflowGraph {
+  DataflowGraph(const TaskGraph &graph, long nb_fields, size_t number, int64_t first_task)
+    : graph(graph)
+    , nb_fields(std::min(std::max(nb_fields, 2L), graph.timesteps))
+    , index(graph)
+    , number(number)
+    , first_task(first_task)
+    , num_tasks(graph.timesteps * index.width)
+    , total_points(0)
+    , remaining(0)
+  {
+    for (long t = 0; t < graph.timesteps; t++) {
+      total_points += index.row_width[t];
+    }
+  }
+
+  int64_t task(long timestep, long point) const
+  {
+    return first_task + timestep * index.width + point;
+  }
+
+  long next_writer(long timestep, long point) const
+  {
+    for (long t = timestep + nb_fields; t < graph.timesteps; t += nb_fields) {
+      if (index.valid(t, point)) return t;
+    }
+    return -1;
+  }
+
+  long prev_writer(long timestep, long point) const
+  {
+    for (long t = timestep - nb_fields; t >= 0; t -= nb_fields) {
+      if (index.valid(t, point)) return t;
+    }
+    return -1;
+  }
+
+  char *output(long timestep, long point) const
+  {
+    return outputs.block((timestep % nb_fields) * index.width + point);
+  }
+
+  TaskGraph graph;
+  long nb_fields;
+  GraphIndex index;
+  Arena outputs;
+  size_t number;
+  int64_t first_task;
+  int64_t num_tasks;
+  long total_points;
+  std::atomic<long> remaining;
+};
+
+DataflowExecutor::DataflowExecutor(WorkerPool &pool, const TaskGraph &graph,
+                                   SchedulingPolicy policy, long nb_fields,
+                                   ArenaPlacement placement, bool huge_pages)
+  : pool(pool)
+  , policy(policy)
+  , count(NULL)
+  , remaining(0)
+  , start_time(0.0)
+  , elastic(NULL)
+{
+  std::vector<TaskGraph> graph_list(1, graph);
+  std::vector<long> nb_fields_list(1, nb_fields);
+  initialize(graph_list, nb_fields_list, placement, huge_pages);
+}
+
+DataflowExecutor::DataflowExecutor(WorkerPool &pool, const std::vector<TaskGraph> &graphs,
+                                   SchedulingPolicy policy,
+                                   ArenaPlacement placement, bool huge_pages)
+  : pool(pool)
+  , policy(policy)
+  , count(NULL)
+  , remaining(0)
+  , start_time(0.0)
+  , elastic(NULL)
+{
+  std::vector<long> nb_fields_list;
+  for (auto &graph : graphs) {
+    nb_fields_list.push_back(graph.nb_fields);
+  }
+  initialize(graphs, nb_fields_list, placement, huge_pages);
+}
+
+void DataflowExecutor::initialize(const std::vector<TaskGraph> &graph_list,
+                                  const std::vector<long> &nb_fields_list,
+                                  ArenaPlacement placement, bool huge_pages)
+{
+  assert(!graph_list.empty() && graph_list.size() == nb_fields_list.size());
+  pthread_mutex_init(&central_lock, NULL);
+
+  int64_t num_tasks = 0;
+  size_t max_inputs = 0;
+  size_t scratch_bytes = 0;
+  for (size_t i = 0; i < graph_list.size(); i++) {
+    DataflowGraph *g = new DataflowGraph(graph_list[i], nb_fields_list[i], i, num_tasks);
+    graphs.push_back(g);
+    num_tasks += g->num_tasks;
+    max_inputs = std::max(max_inputs, g->index.max_inputs);
+    scratch_bytes = std::max(scratch_bytes, g->graph.scratch_bytes_per_task);
+  }
+  completed_at.resize(graphs.size(), 0.0);
+
+  // Initial counters: inputs from the previous timestep plus, when the
+  // output row is reused, the consumers of the previous occupant.
+  initial_count.resize(num_tasks, 0);
+  for (auto g : graphs) {
+    const GraphIndex &index = g->index;
+    long timesteps = g->graph.timesteps;
+
+    for (long t = 0; t < timesteps; t++) {
+      long offset = index.row_offset[t];
+      for (long point = offset; point < offset + index.row_width[t]; point++) {
+        int32_t needed = index.num_inputs(t, point);
+        long prev = g->prev_writer(t, point);
+        if (prev >= 0) {
+          int32_t consumers = index.num_consumers(prev, point);
+          needed += std::max(consumers, 1);
+        }
+        initial_count[g->task(t, point)] = needed;
+        if (needed == 0) {
+          initial_ready.push_back(g->task(t, point));
+        }
+      }
+    }
+
+    g->outputs.allocate(g->nb_fields * index.width, g->graph.max_output_bytes(), placement, huge_pages);
+  }
+  count = new std::atomic<int32_t>[num_tasks];
+
+  // Start the graphs side by side rather than one after the other.
+  std::stable_sort(initial_ready.begin(), initial_ready.end(),
+                   [this](int64_t a, int64_t b) {
+                     return (a - graph_of(a).first_task) < (b - graph_of(b).first_task);
+                   });
+
+  scratch_bytes_per_worker = scratch_bytes;
+  scratch.allocate(pool.size(), scratch_bytes, placement, huge_pages);
+
+  for (int worker = 0; worker < pool.size(); worker++) {
+    // Allocated by hand because new only guarantees alignment of
+    // over-aligned types from C++17.
+    void *mem = NULL;
+    if (posix_memalign(&mem, CACHE_LINE_SIZE, sizeof(DataflowWorker)) != 0) {
+      fprintf(stderr, "error: Unable to allocate worker state\n");
+      abort();
+    }
+    DataflowWorker *w = new (mem) DataflowWorker;
+    w->input_ptr.resize(max_inputs);
+    w->input_bytes.resize(max_inputs);
+    w->scratch_ptr = scratch.block(worker);
+    w->rng = 0x9E3779B97F4A7C15ULL * (worker + 1);
+    workers.push_back(w);
+  }
+
+  // Touch outputs and scratch from the workers that will use them.
+  pool.run(touch_worker, this);
+
+  reset();
+}
+
+DataflowExecutor::~DataflowExecutor()
+{
+  for (auto w : workers) {
+    w->~DataflowWorker();
+    free(w);
+  }
+  for (auto g : graphs) {
+    delete g;
+  }
+  delete [] count;
+  pthread_mutex_destroy(&central_lock);
+}
+
+void DataflowExecutor::touch_worker(int worker, void *arg)
+{
+  DataflowExecutor *self = reinterpret_cast<DataflowExecutor *>(arg);
+  int num_workers = self->pool.size();
+
+  for (auto g : self->graphs) {
+    size_t width = g->index.width;
+    size_t rows = g->nb_fields;
+    size_t first = width * worker / num_workers;
+    size_t last = width * (worker + 1) / num_workers;
+    for (size_t row = 0; row < rows; row++) {
+      g->outputs.touch(row * width + first, last - first);
+    }
+  }
+
+  self->scratch.touch(worker, 1);
+  TaskGraph::prepare_scratch(self->workers[worker]->scratch_ptr, self->scratch_bytes_per_worker);
+}
+
+void DataflowExecutor::reset()
+{
+  for (size_t i = 0; i < initial_count.size(); i++) {
+    count[i].store(initial_count[i], std::memory_order_relaxed);
+  }
+  for (auto g : graphs) {
+    g->remaining.store(g->total_points, std::memory_order_relaxed);
+  }
+  remaining.store(num_tasks(), std::memory_order_release);
+}
+
+void DataflowExecutor::execute()
+{
+  start();
+  pool.run(run_worker, this);
+  assert(remaining.load() == 0);
+}
+
+void DataflowExecutor::start()
+{
+  start_time = Timer::get_cur_time();
+}
+
+void DataflowExecutor::begin(int worker)
+{
+  int num_workers = pool.size();
+  for (size_t i = worker; i < initial_ready.size(); i += num_workers) {
+    push_task(worker, initial_ready[i]);
+  }
+}
+
+bool DataflowExecutor::run_one(int worker)
+{
+  int64_t task;
+  if (!find_task(worker, task)) {
+    return false;
+  }
+  execute_task(worker, task);
+  complete_task(worker, task);
+  return true;
+}
+
+bool DataflowExecutor::finished() const
+{
+  return remaining.load(std::memory_order_acquire) == 0;
+}
+
+void DataflowExecutor::set_elastic(ElasticWorkers *elastic)
+{
+  this->elastic = elastic;
+}
+
+long DataflowExecutor::num_tasks() const
+{
+  long total = 0;
+  for (auto g : graphs) {
+    total += g->total_points;
+  }
+  return total;
+}
+
+void DataflowExecutor::run_worker(int worker, void *arg)
+{
+  reinterpret_cast<DataflowExecutor *>(arg)->worker_loop(worker);
+}
+
+void DataflowExecutor::worker_loop(int worker)
+{
+  begin(worker);
+
+  int idle = 0;
+  while (!finished()) {
+    if (elastic) {
+      elastic->park_if_inactive(worker);
+    }
+    if (run_one(worker)) {
+      idle = 0;
+    } else if (++idle >= SPINS_BEFORE_YIELD) {
+      sched_yield();
+      idle = 0;
+    }
+  }
+}
+
+void DataflowExecutor::push_task(int worker, int64_t task)
+{
+  if (policy == SCHEDULE_CENTRAL) {
+    pthread_mutex_lock(&central_lock);
+    central_queue.push_back(task);
+    pthread_mutex_unlock(&central_lock);
+  } else {
+    workers[worker]->deque.push(task);
+  }
+}
+
+bool DataflowExecutor::find_task(int worker, int64_t &task)
+{
+  if (policy == SCHEDULE_CENTRAL) {
+    bool found = false;
+    pthread_mutex_lock(&central_lock);
+    if (!central_queue.empty()) {
+      task = central_queue.front();
+      central_queue.pop_front();
+      found = true;
+    }
+    pthread_mutex_unlock(&central_lock);
+    return found;
+  }
+
+  DataflowWorker *self = workers[worker];
+  if (self->deque.pop(task)) {
+    return true;
+  }
+
+  int num_workers = pool.size();
+  if (num_workers == 1) {
+    return false;
+  }
+
+  if (policy == SCHEDULE_RANDOM) {
+    // xorshift64
+    self->rng ^= self->rng << 13;
+    self->rng ^= self->rng >> 7;
+    self->rng ^= self->rng << 17;
+    int victim = (worker + 1 + self->rng % (num_workers - 1)) % num_workers;
+    return workers[victim]->deque.steal(task);
+  }
+
+  // Locality: try neighbors in order of increasing distance, which
+  // with compact pinning means cores that share the most cache.
+  for (int distance = 1; distance < num_workers; distance++) {
+    int victim = (worker + (distance % 2 ? 1 : -1) * ((distance + 1) / 2) + num_workers) % num_workers;
+    if (workers[victim]->deque.steal(task)) {
+      return true;
+    }
+  }
+  return false;
+}
+
+inline DataflowGraph &DataflowExecutor::graph_of(int64_t task) const
+{
+  size_t i = graphs.size() - 1;
+  while (task < graphs[i]->first_task) {
+    i--;
+  }
+  return *graphs[i];
+}
+
+void DataflowExecutor::execute_task(int worker, int64_t task)
+{
+  DataflowWorker *self = workers[worker];
+  const DataflowGraph &g = graph_of(task);
+  long t = (task - g.first_task) / g.index.width;
+  long point = (task - g.first_task) % g.index.width;
+  if (elastic) {
+    elastic->reached(t);
+  }
+  execute_indexed(g.graph, g.index, t, point,
+                  [&g](long timestep, long p) { return g.output(timestep, p); },
+                  self->input_ptr.data(), self->input_bytes.data(), self->scratch_ptr);
+}
+
+void DataflowExecutor::release(int worker, const DataflowGraph &g, long timestep, long point)
+{
+  int64_t task = g.task(timestep, point);
+  if (count[task].fetch_sub(1, std::memory_order_acq_rel) == 1) {
+    push_task(worker, task);
+  }
+}
+
+void DataflowExecutor::complete_task(int worker, int64_t task)
+{
+  DataflowGraph &g = graph_of(task);
+  const GraphIndex &index = g.index;
+  long t = (task - g.first_task) / index.width;
+  long point = (task - g.first_task) % index.width;
+
+  // Consumers in the next timestep.
+  int32_t consumers = 0;
+  if (t + 1 < g.graph.timesteps) {
+    size_t ridx = index.dep_index(t + 1, point);
+    for (size_t i = index.rdep_start[ridx]; i < index.rdep_start[ridx + 1]; i++) {
+      std::pair<long, long> span = index.clip(t + 1, index.rdep_spans[i]);
+      for (long consumer = span.first; consumer <= span.second; consumer++) {
+        release(worker, g, t + 1, consumer);
+        consumers++;
+      }
+    }
+  }
+
+  // This task has finished reading its inputs, so their rows may be
+  // reused.
+  if (t > 0) {
+    size_t idx = index.dep_index(t, point);
+    for (size_t i = index.dep_start[idx]; i < index.dep_start[idx + 1]; i++) {
+      std::pair<long, long> deps = index.clip(t - 1, index.dep_spans[i]);
+      for (long dep = deps.first; dep <= deps.second; dep++) {
+        long next = g.next_writer(t - 1, dep);
+        if (next >= 0) {
+          release(worker, g, next, dep);
+        }
+      }
+    }
+  }
+
+  // Nobody reads this output, so the next writer only has to wait for
+  // this task itself.
+  if (consumers == 0) {
+    long next = g.next_writer(t, point);
+    if (next >= 0) {
+      release(worker, g, next, point);
+    }
+  }
+
+  if (g.remaining.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+    completed_at[g.number] = Timer::get_cur_time() - start_time;
+  }
+  if (remaining.fetch_sub(1, std::memory_order_acq_rel) == 1 && elastic) {
+    elastic->release();
+  }
+}
+
+SpinBarrier::SpinBarrier(int count)
+  : count(count)
+  , arrived(0)
+  , generation(0)
+{
+}
+
+void SpinBarrier::wait()
+{
+  wait(count, [] {});
+}
+
+void SpinBarrier::spin_while(unsigned current)
+{
+  int spins = 0;
+  while (generation.load(std::memory_order_acquire) == current) {
+    if (++spins >= SPINS_BEFORE_YIELD) {
+      sched_yield();
+      spins = 0;
+    }
+  }
+}
+
+// One graph of a BulkSynchronousExecutor. Its points occupy
+// [first_point, first_point + width) of the space that is split among
+// the workers.
+struct BulkSynchronousGraph {
+  BulkSynchronousGraph(const TaskGraph &graph, long nb_fields, long first_point)
+    : graph(graph)
+    , nb_fields(std::min(std::max(nb_fields, 2L), graph.timesteps))
+    , index(graph)
+    , first_point(first_point)
+  {
+  }
+
+  char *output(long timestep, long point) const
+  {
+    return outputs.block(point * nb_fields + timestep % nb_fields);
+  }
+
+  TaskGraph graph;
+  long nb_fields;
+  GraphIndex index;
+  Arena outputs;
+  long first_point;
+};
+
+struct alignas(CACHE_LINE_SIZE) BulkSynchronousWorker {
+  std::vector<const char *> input_ptr;
+  std::vector<size_t> input_bytes;
+  char *scratch_ptr;
+  // owned points [first, last) of each graph
+  std::vector<std::pair<long, long> > points;
+};
+
+BulkSynchronousExecutor::BulkSynchronousExecutor(WorkerPool &pool, const TaskGraph &graph,
+                                                 long nb_fields, ArenaPlacement placement,
+                                                 bool huge_pages)
+  : pool(pool)
+  , timesteps(0)
+  , total_width(0)
+  , barrier(pool.size())
+  , start_time(0.0)
+  , elastic(NULL)
+{
+  std::vector<TaskGraph> graph_list(1, graph);
+  std::vector<long> nb_fields_list(1, nb_fields);
+  initialize(graph_list, nb_fields_list, placement, huge_pages);
+}
+
+BulkSynchronousExecutor::BulkSynchronousExecutor(WorkerPool &pool, const std::vector<TaskGraph> &graphs,
+                                                 ArenaPlacement placement, bool huge_pages)
+  : pool(pool)
+  , timesteps(0)
+  , total_width(0)
+  , barrier(pool.size())
+  , start_time(0.0)
+  , elastic(NULL)
+{
+  std::vector<long> nb_fields_list;
+  for (auto &graph : graphs) {
+    nb_fields_list.push_back(graph.nb_fields);
+  }
+  initialize(graphs, nb_fields_list, placement, huge_pages);
+}
+
+void BulkSynchronousExecutor::initialize(const std::vector<TaskGraph> &graph_list,
+                                         const std::vector<long> &nb_fields_list,
+                                         ArenaPlacement placement, bool huge_pages)
+{
+  assert(!graph_list.empty() && graph_list.size() == nb_fields_list.size());
+
+  size_t max_inputs = 0;
+  size_t scratch_bytes = 0;
+  for (size_t i = 0; i < graph_list.size(); i++) {
+    BulkSynchronousGraph *g = new BulkSynchronousGraph(graph_list[i], nb_fields_list[i], total_width);
+    g->outputs.allocate(g->index.width * g->nb_fields, g->graph.max_output_bytes(), placement, huge_pages);
+    graphs.push_back(g);
+    total_width += g->index.width;
+    timesteps = std::max(timesteps, g->index.timesteps);
+    max_inputs = std::max(max_inputs, g->index.max_inputs);
+    scratch_bytes = std::max(scratch_bytes, g->graph.scratch_bytes_per_task);
+  }
+  completed_at.resize(graphs.size(), 0.0);
+
+  scratch_bytes_per_worker = scratch_bytes;
+  scratch.allocate(pool.size(), scratch_bytes, placement, huge_pages);
+
+  int num_workers = pool.size();
+  for (int worker = 0; worker < num_workers; worker++) {
+    void *mem = NULL;
+    if (posix_memalign(&mem, CACHE_LINE_SIZE, sizeof(BulkSynchronousWorker)) != 0) {
+      fprintf(stderr, "error: Unable to allocate worker state\n");
+      abort();
+    }
+    BulkSynchronousWorker *w = new (mem) BulkSynchronousWorker;
+    w->input_ptr.resize(max_inputs);
+    w->input_bytes.resize(max_inputs);
+    w->scratch_ptr = scratch.block(worker);
+    for (auto g : graphs) {
+      w->points.push_back(owned_points(g, worker, num_workers));
+    }
+    workers.push_back(w);
+  }
+
+  pool.run(touch_worker, this);
+}
+
+std::pair<long, long> BulkSynchronousExecutor::owned_points(const BulkSynchronousGraph *g,
+                                                           int worker, int num_workers) const
+{
+  long first = total_width * worker / num_workers;
+  long last = total_width * (worker + 1) / num_workers;
+  long begin = std::min(std::max(first, g->first_point) - g->first_point, g->index.width);
+  long end = std::min(last, g->first_point + g->index.width) - g->first_point;
+  return std::make_pair(begin, std::max(begin, end));
+}
+
+BulkSynchronousExecutor::~BulkSynchronousExecutor()
+{
+  for (auto w : workers) {
+    w->~BulkSynchronousWorker();
+    free(w);
+  }
+  for (auto g : graphs) {
+    delete g;
+  }
+}
+
+void BulkSynchronousExecutor::touch_worker(int worker, void *arg)
+{
+  BulkSynchronousExecutor *self = reinterpret_cast<BulkSynchronousExecutor *>(arg);
+  BulkSynchronousWorker *w = self->workers[worker];
+
+  for (size_t i = 0; i < self->graphs.size(); i++) {
+    BulkSynchronousGraph *g = self->graphs[i];
+    g->outputs.touch(w->points[i].first * g->nb_fields,
+                     (w->points[i].second - w->points[i].first) * g->nb_fields);
+  }
+  self->scratch.touch(worker, 1);
+  TaskGraph::prepare_scratch(w->scratch_ptr, self->scratch_bytes_per_worker);
+}
+
+void BulkSynchronousExecutor::set_elastic(ElasticWorkers *elastic)
+{
+  this->elastic = elastic;
+}
+
+void BulkSynchronousExecutor::execute()
+{
+  start_time = Timer::get_cur_time();
+  if (elastic) {
+    elastic->reached(0);
+  }
+  pool.run(run_worker, this);
+  double end_time = Timer::get_cur_time();
+  for (size_t i = 0; i < graphs.size(); i++) {
+    if (graphs[i]->index.timesteps == timesteps) {
+      completed_at[i] = end_time - start_time;
+    }
+  }
+}
+
+void BulkSynchronousExecutor::run_worker(int worker, void *arg)
+{
+  reinterpret_cast<BulkSynchronousExecutor *>(arg)->worker_loop(worker);
+}
+
+void BulkSynchronousExecutor::worker_loop(int worker)
+{
+  BulkSynchronousWorker *self = workers[worker];
+  int num_workers = pool.size();
+
+  for (long t = 0; t < timesteps; t++) {
+    int active = elastic ? elastic->workers_at(t) : num_workers;
+    if (worker >= active) {
+      // Worker 0 is always active, so this worker is needed again only
+      // at a timestep whose count exceeds it. That count is published
+      // when the previous timestep's barrier completes, and no later
+      // barrier can complete without this worker.
+      while (t < timesteps && worker >= elastic->workers_at(t)) {
+        t++;
+      }
+      if (t == timesteps) {
+        break;
+      }
+      elastic->park_if_inactive(worker);
+      active = elastic->workers_at(t);
+    }
+
+    for (size_t i = 0; i < graphs.size(); i++) {
+      const BulkSynchronousGraph *g = graphs[i];
+      const GraphIndex &index = g->index;
+      if (t >= index.timesteps) continue;
+      auto output_fn = [g](long timestep, long p) { return g->output(timestep, p); };
+      std::pair<long, long> owned = active == num_workers ? self->points[i] : owned_points(g, worker, active);
+      long first = std::max(owned.first, index.row_offset[t]);
+      long last = std::min(owned.second, index.row_offset[t] + index.row_width[t]);
+      for (long point = first; point < last; point++) {
+        execute_indexed(g->graph, index, t, point, output_fn,
+                        self->input_ptr.data(), self->input_bytes.data(), self->scratch_ptr);
+      }
+    }
+    // pool.run() already waits for everyone after the last timestep.
+    if (t + 1 < timesteps) {
+      ElasticWorkers *elastic = this->elastic;
+      barrier.wait(active, [elastic, t] {
+        if (elastic) {
+          elastic->reached(t + 1);
+        }
+      });
+      if (worker == 0) {
+        for (size_t i = 0; i < graphs.size(); i++) {
+          if (graphs[i]->index.timesteps == t + 1) {
+            completed_at[i] = Timer::get_cur_time() - start_time;
+          }
+        }
+      }
+    }
+  }
+}
+
+MultiTenantExecutor::MultiTenantExecutor(WorkerPool &pool,
+                                         const std::vector<DataflowExecutor *> &tenants,
+                                         TenantPolicy policy)
+  : pool(pool)
+  , tenants(tenants)
+  , policy(policy)
+{
+  assert(!tenants.empty());
+  served_counts.allocate(tenants.size(), sizeof(std::atomic<int64_t>), PLACEMENT_NONE, false);
+  served_counts.touch(0, tenants.size());
+  completed_at.resize(tenants.size(), 0.0);
+}
+
+inline std::atomic<int64_t> &MultiTenantExecutor::served(size_t tenant) const
+{
+  return *reinterpret_cast<std::atomic<int64_t> *>(served_counts.block(tenant));
+}
+
+void MultiTenantExecutor::reset()
+{
+  for (size_t i = 0; i < tenants.size(); i++) {
+    tenants[i]->reset();
+    served(i).store(0, std::memory_order_relaxed);
+  }
+}
+
+void MultiTenantExecutor::execute()
+{
+  for (auto tenant : tenants) {
+    tenant->start();
+  }
+  pool.run(run_worker, this);
+
+  // All tenants started together, so their own completion times share
+  // the same origin.
+  for (size_t i = 0; i < tenants.size(); i++) {
+    const std::vector<double> &times = tenants[i]->completion_times();
+    completed_at[i] = *std::max_element(times.begin(), times.end());
+  }
+}
+
+void MultiTenantExecutor::run_worker(int worker, void *arg)
+{
+  reinterpret_cast<MultiTenantExecutor *>(arg)->worker_loop(worker);
+}
+
+void MultiTenantExecutor::worker_loop(int worker)
+{
+  size_t num_tenants = tenants.size();
+  for (auto tenant : tenants) {
+    tenant->begin(worker);
+  }
+
+  std::vector<size_t> order(num_tenants);
+  for (size_t i = 0; i < num_tenants; i++) {
+    order[i] = i;
+  }
+
+  int idle = 0;
+  while (true) {
+    if (policy == TENANT_FAIR_SHARE) {
+      // Insertion sort: the order barely changes between tasks.
+      for (size_t i = 1; i < num_tenants; i++) {
+        size_t tenant = order[i];
+        int64_t count = served(tenant).load(std::memory_order_relaxed);
+        size_t j = i;
+        for (; j > 0 && served(order[j - 1]).load(std::memory_order_relaxed) > count; j--) {
+          order[j] = order[j - 1];
+        }
+        order[j] = tenant;
+      }
+    }
+
+    bool ran = false;
+    bool finished = true;
+    for (size_t i = 0; i < num_tenants && !ran; i++) {
+      size_t tenant = order[i];
+      if (tenants[tenant]->finished()) continue;
+      finished = false;
+      if (!tenants[tenant]->is_active(worker)) continue;
+      if (tenants[tenant]->run_one(worker)) {
+        served(tenant).fetch_add(1, std::memory_order_relaxed);
+        ran = true;
+      }
+    }
+    if (finished) {
+      break;
+    }
+
+    if (ran) {
+      idle = 0;
+    } else if (++idle >= SPINS_BEFORE_YIELD) {
+      sched_yield();
+      idle = 0;
+    }
+  }
+}
@@ -0,0 +1,451 @@
+/* Copyright 2020 Stanford University
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef CORE_EXECUTOR_H
+#define CORE_EXECUTOR_H
+
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <deque>
+#include <vector>
+
+#include <pthread.h>
+
+#include "core.h"
+
+enum SchedulingPolicy {
+  SCHEDULE_CENTRAL, // one shared queue
+  SCHEDULE_RANDOM, // per-worker deques, steal from a random victim
+  SCHEDULE_LOCALITY, // per-worker deques, steal from the nearest workers first
+};
+
+// Persistent pool of worker threads, optionally pinned to the CPUs the
+// process is allowed to run on. The thread that calls run() acts as
+// worker 0, so a pool of N workers starts N-1 threads. Threads sleep
+// between jobs and are reused across graphs and repetitions.
+class WorkerPool {
+public:
+  // Each worker, including the caller as worker 0, is pinned as
+  // pinning says; pinning must outlive the pool. NULL leaves threads
+  // unpinned.
+  explicit WorkerPool(int workers, const ThreadPinning *pinning = NULL);
+  ~WorkerPool();
+
+  int size() const { return num_workers; }
+
+  // Calls fn(worker, arg) once on every worker and waits for all of
+  // them to return.
+  void run(void (*fn)(int worker, void *arg), void *arg);
+
+private:
+  WorkerPool(const WorkerPool &) = delete;
+  WorkerPool &operator=(const WorkerPool &) = delete;
+
+  static void *thread_main(void *arg);
+  void worker_main(int worker);
+
+  int num_workers;
+  const ThreadPinning *pinning;
+  std::vector<pthread_t> threads;
+  pthread_mutex_t lock;
+  pthread_cond_t wake;
+  pthread_cond_t finished;
+  long generation;
+  int pending;
+  bool shutdown;
+  void (*job)(int, void *);
+  void *job_arg;
+};
+
+// Active worker count that follows a schedule while a job runs.
+// Workers at or above the current count park on a futex and are woken
+// when it grows again, so an executor can shrink and grow without
+// restarting its threads. Executors call reached() as they start each
+// timestep, which also records when that happened.
+class ElasticWorkers {
+public:
+  // Each entry (T, N) means that from timestep T on N workers are
+  // active; before the first entry all of them are.
+  typedef std::vector<std::pair<long, int> > Schedule;
+
+  // Parses "T:N[,T:N...]" with increasing T and 1 <= N <= workers.
+  // Aborts with an error otherwise.
+  static Schedule parse_schedule(const char *spec, int workers);
+
+  ElasticWorkers(int workers, const Schedule &schedule, long timesteps);
+  ~ElasticWorkers();
+
+  // Makes all workers active again and forgets the timings. Call
+  // before each run.
+  void reset();
+  void reached(long timestep);
+  // Blocks while worker is not among the active ones.
+  void park_if_inactive(int worker);
+  bool is_active(int worker) const
+  {
+    return worker < active.load(std::memory_order_acquire);
+  }
+  // Active workers at timestep according to the schedule, whether or
+  // not the run has got there yet.
+  int workers_at(long timestep) const;
+  // Makes all workers active for good, so that parked workers can see
+  // that the job has ended.
+  void release();
+
+  // Prints the steady throughput of each phase of the schedule and
+  // how many timesteps it took to settle after the switch.
+  void report(const std::vector<TaskGraph> &graphs) const;
+
+private:
+  ElasticWorkers(const ElasticWorkers &) = delete;
+  ElasticWorkers &operator=(const ElasticWorkers &) = delete;
+
+  int workers;
+  Schedule schedule;
+  std::vector<double> reached_at;
+  std::atomic<long> next_step;
+  std::atomic<long> progress;
+  pthread_mutex_t step_lock;
+  // futex word
+  std::atomic<int> active;
+};
+
+// Shape of every timestep and the dependencies of every (dset, point),
+// flattened so that executors never call dependencies() while running.
+struct GraphIndex {
+  explicit GraphIndex(const TaskGraph &graph);
+
+  bool valid(long timestep, long point) const
+  {
+    return point >= row_offset[timestep] && point < row_offset[timestep] + row_width[timestep];
+  }
+
+  // Dependencies of point at timestep are the inclusive intervals
+  // dep_spans[dep_start[i] .. dep_start[i+1]) with i =
+  // dep_index(timestep, point). Consumers of point at timestep - 1 are
+  // rdep_spans[rdep_start[i] .. rdep_start[i+1]) for the same i.
+  // Intervals keep the index O(width) for dense patterns.
+  size_t dep_index(long timestep, long point) const
+  {
+    return row_dset[timestep] * width + point;
+  }
+
+  // The part of span that exists at timestep; empty when first > second.
+  std::pair<long, long> clip(long timestep, const std::pair<long, long> &span) const
+  {
+    return std::pair<long, long>(std::max(span.first, row_offset[timestep]),
+                                 std::min(span.second, row_offset[timestep] + row_width[timestep] - 1));
+  }
+
+  // Inputs of (timestep, point) that exist at timestep - 1.
+  size_t num_inputs(long timestep, long point) const;
+  // Consumers of (timestep, point) that exist at timestep + 1.
+  size_t num_consumers(long timestep, long point) const;
+
+  long timesteps;
+  long width;
+  std::vector<long> row_offset;
+  std::vector<long> row_width;
+  std::vector<long> row_dset;
+  std::vector<size_t> dep_start;
+  std::vector<std::pair<long, long> > dep_spans;
+  std::vector<size_t> rdep_start;
+  std::vector<std::pair<long, long> > rdep_spans;
+  size_t max_inputs;
+};
+
+// Gathers the inputs of (t, point) from the previous timestep and runs
+// it. output(t, point) returns the output of any task; inputs and
+// sizes must hold index.max_inputs entries.
+template <typename OutputFn>
+inline void execute_indexed(const TaskGraph &graph, const GraphIndex &index,
+                            long t, long point, OutputFn output,
+                            const char **inputs, size_t *sizes, char *scratch_ptr)
+{
+  bool uniform_output = graph.output_distribution == OutputDistribution::OUTPUT_UNIFORM;
+  size_t n_inputs = 0;
+  if (t > 0) {
+    size_t idx = index.dep_index(t, point);
+    for (size_t i = index.dep_start[idx]; i < index.dep_start[idx + 1]; i++) {
+      std::pair<long, long> deps = index.clip(t - 1, index.dep_spans[i]);
+      for (long dep = deps.first; dep <= deps.second; dep++) {
+        if (uniform_output) {
+          inputs[n_inputs] = output(t - 1, dep);
+          sizes[n_inputs] = graph.output_bytes_per_task;
+        } else {
+          inputs[n_inputs] = output(t - 1, dep) + graph.output_field_offset(t - 1, dep, point);
+          sizes[n_inputs] = graph.output_field_bytes(t - 1, dep, point);
+        }
+        n_inputs++;
+      }
+    }
+  }
+
+  size_t output_bytes = uniform_output ? graph.output_bytes_per_task : graph.task_output_bytes(t, point);
+  graph.execute_point(t, point, output(t, point), output_bytes,
+                      inputs, sizes, n_inputs,
+                      scratch_ptr, graph.scratch_bytes_per_task);
+}
+
+// Common interface of the executors below, so that drivers can choose
+// one at run time.
+class Executor {
+public:
+  virtual ~Executor() {}
+
+  // Prepares for the next execute(). Must be called before each
+  // execute(), outside of any timed region.
+  virtual void reset() {}
+  virtual void execute() = 0;
+
+  // Seconds from the start of the last execute() until each of its
+  // graphs completed, in the order the graphs were given.
+  const std::vector<double> &completion_times() const { return completed_at; }
+
+protected:
+  std::vector<double> completed_at;
+};
+
+struct TaskDeque;
+struct DataflowWorker;
+struct DataflowGraph;
+
+// Executes a task graph as a dataflow DAG on a WorkerPool. Each task
+// carries an atomic counter of unsatisfied dependencies; completing a
+// task decrements the counters of its consumers (found through a
+// reverse dependency index) and pushes those that reach zero.
+//
+// Outputs live in a ring of nb_fields rows. A task that would reuse a
+// row also waits for every consumer of the previous occupant (or for
+// the previous occupant itself, if it has none), so the ring is safe
+// for any nb_fields >= 2 and larger rings allow more run-ahead.
+//
+// Several graphs may share one executor. Their tasks are independent
+// and are scheduled together, so narrow phases of one graph are filled
+// with tasks of the others.
+class DataflowExecutor : public Executor {
+public:
+  DataflowExecutor(WorkerPool &pool, const TaskGraph &graph,
+                   SchedulingPolicy policy, long nb_fields,
+                   ArenaPlacement placement, bool huge_pages);
+  // Each graph keeps its own nb_fields.
+  DataflowExecutor(WorkerPool &pool, const std::vector<TaskGraph> &graphs,
+                   SchedulingPolicy policy,
+                   ArenaPlacement placement, bool huge_pages);
+  ~DataflowExecutor();
+
+  // Re-arms the dependency counters.
+  void reset();
+  void execute();
+
+  // Lets a driver run several executors on one pool. After reset(),
+  // call start() once, then on every worker begin(worker) and
+  // run_one(worker) until finished().
+  void start();
+  void begin(int worker);
+  bool run_one(int worker);
+  bool finished() const;
+  long num_tasks() const;
+
+  // Follow elastic's worker count from the next execute() on; NULL to
+  // keep every worker active.
+  void set_elastic(ElasticWorkers *elastic);
+  bool is_active(int worker) const
+  {
+    return !elastic || elastic->is_active(worker);
+  }
+
+private:
+  DataflowExecutor(const DataflowExecutor &) = delete;
+  DataflowExecutor &operator=(const DataflowExecutor &) = delete;
+
+  void initialize(const std::vector<TaskGraph> &graph_list,
+                  const std::vector<long> &nb_fields_list,
+                  ArenaPlacement placement, bool huge_pages);
+  static void run_worker(int worker, void *arg);
+  static void touch_worker(int worker, void *arg);
+  void worker_loop(int worker);
+  bool find_task(int worker, int64_t &task);
+  void push_task(int worker, int64_t task);
+  void execute_task(int worker, int64_t task);
+  void complete_task(int worker, int64_t task);
+  void release(int worker, const DataflowGraph &g, long timestep, long point);
+  DataflowGraph &graph_of(int64_t task) const;
+
+  WorkerPool &pool;
+  SchedulingPolicy policy;
+  std::vector<DataflowGraph *> graphs;
+
+  std::vector<int32_t> initial_count;
+  std::vector<int64_t> initial_ready;
+  std::atomic<int32_t> *count;
+  std::atomic<int64_t> remaining;
+  double start_time;
+  ElasticWorkers *elastic;
+
+  Arena scratch;
+  size_t scratch_bytes_per_worker;
+  std::vector<DataflowWorker *> workers;
+
+  pthread_mutex_t central_lock;
+  std::deque<int64_t> central_queue;
+};
+
+// Central barrier. Waiters spin on a generation counter and yield
+// after a while, so oversubscribed runs still make progress. Unlike a
+// sense flag, the counter cannot flip back, so a waiter that is slow
+// to notice its release still leaves after later waits have completed
+// without it.
+class SpinBarrier {
+public:
+  explicit SpinBarrier(int count);
+
+  void wait();
+  // Waits for the first count participants only. The last of them to
+  // arrive runs complete() before releasing the others.
+  template <typename Fn>
+  void wait(int count, Fn complete);
+
+private:
+  void spin_while(unsigned current);
+
+  // Padded rather than aligned so that owners can still be created
+  // with plain new before C++17.
+  int count;
+  char pad0[CACHE_LINE_SIZE];
+  std::atomic<int> arrived;
+  char pad1[CACHE_LINE_SIZE];
+  std::atomic<unsigned> generation;
+  char pad2[CACHE_LINE_SIZE];
+};
+
+template <typename Fn>
+inline void SpinBarrier::wait(int count, Fn complete)
+{
+  // Cannot move on before this caller arrives.
+  unsigned current = generation.load(std::memory_order_acquire);
+  if (arrived.fetch_add(1, std::memory_order_acq_rel) == count - 1) {
+    arrived.store(0, std::memory_order_relaxed);
+    complete();
+    generation.store(current + 1, std::memory_order_release);
+    return;
+  }
+  spin_while(current);
+}
+
+struct BulkSynchronousWorker;
+struct BulkSynchronousGraph;
+
+// Executes a task graph one timestep at a time. Each worker owns a
+// fixed contiguous block of points, and a barrier separates
+// consecutive timesteps. This is the shared-memory analogue of
+// mpi/bulk_synchronous.cc: no per-task scheduling at all, at the price
+// of waiting for the slowest worker at every timestep.
+//
+// Outputs of a worker's points are stored together (all nb_fields
+// rows of a point are adjacent), so each worker writes one contiguous
+// slice. The barrier makes any nb_fields >= 2 safe.
+//
+// Several graphs may share one executor. They then advance in
+// lockstep, one timestep of every graph between barriers, and the
+// workers split the points of all graphs together.
+//
+// With an ElasticWorkers, each timestep is split among the workers
+// active at that timestep only, the barrier waits for just those, and
+// the others park until a later timestep needs them.
+class BulkSynchronousExecutor : public Executor {
+public:
+  BulkSynchronousExecutor(WorkerPool &pool, const TaskGraph &graph,
+                          long nb_fields, ArenaPlacement placement, bool huge_pages);
+  // Each graph keeps its own nb_fields.
+  BulkSynchronousExecutor(WorkerPool &pool, const std::vector<TaskGraph> &graphs,
+                          ArenaPlacement placement, bool huge_pages);
+  ~BulkSynchronousExecutor();
+
+  void execute();
+
+  // Follow elastic's worker count from the next execute() on; NULL to
+  // keep every worker active.
+  void set_elastic(ElasticWorkers *elastic);
+
+private:
+  BulkSynchronousExecutor(const BulkSynchronousExecutor &) = delete;
+  BulkSynchronousExecutor &operator=(const BulkSynchronousExecutor &) = delete;
+
+  void initialize(const std::vector<TaskGraph> &graph_list,
+                  const std::vector<long> &nb_fields_list,
+                  ArenaPlacement placement, bool huge_pages);
+  // Points [first, last) of g that worker owns when num_workers split
+  // the points of all graphs.
+  std::pair<long, long> owned_points(const BulkSynchronousGraph *g,
+                                     int worker, int num_workers) const;
+  static void run_worker(int worker, void *arg);
+  static void touch_worker(int worker, void *arg);
+  void worker_loop(int worker);
+
+  WorkerPool &pool;
+  std::vector<BulkSynchronousGraph *> graphs;
+  long timesteps;
+  long total_width;
+
+  Arena scratch;
+  size_t scratch_bytes_per_worker;
+  std::vector<BulkSynchronousWorker *> workers;
+  SpinBarrier barrier;
+  double start_time;
+  ElasticWorkers *elastic;
+};
+
+enum TenantPolicy {
+  TENANT_FAIR_SHARE, // run a task of the tenant that has run the fewest so far
+  TENANT_PRIORITY, // run a task of the first tenant that has one
+};
+
+// Runs several independent DataflowExecutors, one per tenant, on a
+// single WorkerPool. Before each task a worker picks a tenant according
+// to the policy and falls back to the others when it has no ready task.
+// Fair share counts tasks rather than time, so tenants with costlier
+// tasks get more of the machine.
+//
+// Tenants may follow their own ElasticWorkers. A worker skips the
+// tenants it is inactive for and keeps serving the others.
+class MultiTenantExecutor : public Executor {
+public:
+  MultiTenantExecutor(WorkerPool &pool, const std::vector<DataflowExecutor *> &tenants,
+                      TenantPolicy policy);
+
+  void reset();
+  void execute();
+
+  // completion_times() has one entry per tenant: when its last graph
+  // completed.
+
+private:
+  MultiTenantExecutor(const MultiTenantExecutor &) = delete;
+  MultiTenantExecutor &operator=(const MultiTenantExecutor &) = delete;
+
+  static void run_worker(int worker, void *arg);
+  void worker_loop(int worker);
+  std::atomic<int64_t> &served(size_t tenant) const;
+
+  WorkerPool &pool;
+  std::vector<DataflowExecutor *> tenants;
+  TenantPolicy policy;
+  // tasks run per tenant, one cache line each
+  Arena served_counts;
+};
+
+#endif
@@ -0,0 +1,274 @@
+/* Copyright 2020 Stanford University
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <algorithm>
+#include <map>
+
+#include <pthread.h>
+#include <sched.h>
+#include <unistd.h>
+
+#include "core_topology.h"
+
+#define SYSFS_CPU "/sys/devices/system/cpu"
+#define SYSFS_NODE "/sys/devices/system/node"
+
+bool parse_cpu_list(const char *spec, std::vector<int> &cpus)
+{
+  const char *p = spec;
+  while (*p && *p != '\n') {
+    char *end = NULL;
+    long first = strtol(p, &end, 10);
+    if (end == p || first < 0) return false;
+    long last = first;
+    p = end;
+    if (*p == '-') {
+      p++;
+      last = strtol(p, &end, 10);
+      if (end == p || last < first) return false;
+      p = end;
+    }
+    for (long cpu = first; cpu <= last; cpu++) {
+      cpus.push_back(cpu);
+    }
+    if (*p == ',') {
+      p++;
+    } else if (*p && *p != '\n') {
+      return false;
+    }
+  }
+  return !cpus.empty();
+}
+
+#ifdef __linux__
+static long read_sysfs_long(const char *path, long fallback)
+{
+  FILE *f = fopen(path, "r");
+  if (!f) {
+    return fallback;
+  }
+  long value;
+  if (fscanf(f, "%ld", &value) != 1) {
+    value = fallback;
+  }
+  fclose(f);
+  return value;
+}
+
+static bool read_sysfs_cpu_list(const char *path, std::vector<int> &cpus)
+{
+  FILE *f = fopen(path, "r");
+  if (!f) {
+    return false;
+  }
+  char line[4096];
+  bool ok = fgets(line, sizeof(line), f) && parse_cpu_list(line, cpus);
+  fclose(f);
+  return ok;
+}
+#endif
+
+std::vector<CpuInfo> allowed_cpus()
+{
+  std::vector<CpuInfo> cpus;
+#ifdef __linux__
+  cpu_set_t allowed;
+  CPU_ZERO(&allowed);
+  if (sched_getaffinity(0, sizeof(allowed), &allowed) != 0) {
+    CPU_ZERO(&allowed);
+    CPU_SET(0, &allowed);
+  }
+
+  std::map<int, int> node_of_cpu;
+  std::vector<int> nodes;
+  if (read_sysfs_cpu_list(SYSFS_NODE "/online", nodes)) {
+    for (int node : nodes) {
+      char path[256];
+      snprintf(path, sizeof(path), SYSFS_NODE "/node%d/cpulist", node);
+      std::vector<int> node_cpus;
+      read_sysfs_cpu_list(path, node_cpus);
+      for (int cpu : node_cpus) {
+        node_of_cpu[cpu] = node;
+      }
+    }
+  }
+
+  for (int cpu = 0; cpu < CPU_SETSIZE; cpu++) {
+    if (!CPU_ISSET(cpu, &allowed)) continue;
+    char path[256];
+    CpuInfo info;
+    info.cpu = cpu;
+    snprintf(path, sizeof(path), SYSFS_CPU "/cpu%d/topology/core_id", cpu);
+    info.core = read_sysfs_long(path, cpu);
+    snprintf(path, sizeof(path), SYSFS_CPU "/cpu%d/topology/physical_package_id", cpu);
+    info.socket = std::max(0L, read_sysfs_long(path, 0));
+    auto node = node_of_cpu.find(cpu);
+    info.node = node != node_of_cpu.end() ? node->second : 0;
+    cpus.push_back(info);
+  }
+#else
+  long online = sysconf(_SC_NPROCESSORS_ONLN);
+  for (int cpu = 0; cpu < std::max(1L, online); cpu++) {
+    CpuInfo info = {cpu, cpu, 0, 0};
+    cpus.push_back(info);
+  }
+#endif
+
+  std::sort(cpus.begin(), cpus.end(), [](const CpuInfo &a, const CpuInfo &b) {
+    if (a.socket != b.socket) return a.socket < b.socket;
+    if (a.core != b.core) return a.core < b.core;
+    return a.cpu < b.cpu;
+  });
+  return cpus;
+}
+
+const char *pin_policy_name(PinPolicy policy)
+{
+  switch (policy) {
+  case PIN_NONE: return "none";
+  case PIN_COMPACT: return "compact";
+  case PIN_SCATTER: return "scatter";
+  case PIN_CORE: return "core";
+  case PIN_SOCKET: return "socket";
+  case PIN_LIST: return "list";
+  }
+  return "unknown";
+}
+
+// CPUs of cpus (sorted as by allowed_cpus) grouped per socket, then
+// per core.
+static std::vector<std::vector<std::vector<int> > > group_by_core(const std::vector<CpuInfo> &cpus)
+{
+  std::vector<std::vector<std::vector<int> > > sockets;
+  for (size_t i = 0; i < cpus.size(); i++) {
+    bool new_socket = i == 0 || cpus[i].socket != cpus[i - 1].socket;
+    if (new_socket) {
+      sockets.emplace_back();
+    }
+    if (new_socket || cpus[i].core != cpus[i - 1].core) {
+      sockets.back().emplace_back();
+    }
+    sockets.back().back().push_back(cpus[i].cpu);
+  }
+  return sockets;
+}
+
+ThreadPinning::ThreadPinning(PinPolicy policy, const std::vector<int> &cpu_list, int workers)
+  : policy(policy)
+  , cpus(allowed_cpus())
+{
+  if (policy == PIN_NONE) {
+    return;
+  }
+
+  std::vector<int> order;
+  auto sockets = group_by_core(cpus);
+  switch (policy) {
+  case PIN_COMPACT:
+    for (auto &info : cpus) {
+      order.push_back(info.cpu);
+    }
+    break;
+  case PIN_SCATTER: {
+    // Round-robin over sockets, then over the cores of each socket,
+    // and only then over SMT siblings.
+    size_t max_cores = 0, max_threads = 0;
+    for (auto &cores : sockets) {
+      max_cores = std::max(max_cores, cores.size());
+      for (auto &threads : cores) {
+        max_threads = std::max(max_threads, threads.size());
+      }
+    }
+    for (size_t thread = 0; thread < max_threads; thread++) {
+      for (size_t core = 0; core < max_cores; core++) {
+        for (auto &cores : sockets) {
+          if (core < cores.size() && thread < cores[core].size()) {
+            order.push_back(cores[core][thread]);
+          }
+        }
+      }
+    }
+    break;
+  }
+  case PIN_CORE:
+    for (auto &cores : sockets) {
+      for (auto &threads : cores) {
+        order.push_back(threads[0]);
+      }
+    }
+    break;
+  case PIN_SOCKET:
+    for (auto &cores : sockets) {
+      order.push_back(cores[0][0]);
+    }
+    break;
+  case PIN_LIST:
+    for (int cpu : cpu_list) {
+      bool found = false;
+      for (auto &info : cpus) {
+        found = found || info.cpu == cpu;
+      }
+      if (!found) {
+        fprintf(stderr, "error: CPU %d in \"-pin\" is not available to this process\n", cpu);
+        abort();
+      }
+      order.push_back(cpu);
+    }
+    break;
+  case PIN_NONE:
+    break;
+  }
+
+  if ((size_t)workers > order.size()) {
+    fprintf(stderr, "warning: %d workers for %zu CPUs with \"-pin %s\", so some share a CPU\n",
+            workers, order.size(), pin_policy_name(policy));
+  }
+  for (int worker = 0; worker < workers; worker++) {
+    mapping.push_back(order[worker % order.size()]);
+  }
+}
+
+void ThreadPinning::pin(int worker) const
+{
+  if (mapping.empty()) {
+    return;
+  }
+#ifdef __linux__
+  cpu_set_t cpuset;
+  CPU_ZERO(&cpuset);
+  CPU_SET(mapping[worker], &cpuset);
+  int rc = pthread_setaffinity_np(pthread_self(), sizeof(cpuset), &cpuset);
+  if (rc != 0) {
+    fprintf(stderr, "warning: Unable to pin worker %d to CPU %d (error %d)\n", worker, mapping[worker], rc);
+  }
+#endif
+}
+
+void ThreadPinning::display() const
+{
+  printf("Pinning: %s\n", pin_policy_name(policy));
+  for (size_t worker = 0; worker < mapping.size(); worker++) {
+    for (auto &info : cpus) {
+      if (info.cpu == mapping[worker]) {
+        printf("  Worker %zu: CPU %d (socket %d, core %d, node %d)\n",
+               worker, info.cpu, info.socket, info.core, info.node);
+        break;
+      }
+    }
+  }
+}
@@ -0,0 +1,70 @@
+/* Copyright 2020 Stanford University
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef CORE_TOPOLOGY_H
+#define CORE_TOPOLOGY_H
+
+#include <string>
+#include <vector>
+
+enum PinPolicy {
+  PIN_NONE, // threads run wherever the OS puts them
+  PIN_COMPACT, // fill SMT siblings, then cores, then sockets
+  PIN_SCATTER, // spread over sockets first, then cores, SMT siblings last
+  PIN_CORE, // one worker per physical core
+  PIN_SOCKET, // one worker per socket
+  PIN_LIST, // the CPUs given explicitly, in order
+};
+
+// One hardware thread the process is allowed to run on, as described
+// by /sys/devices/system/cpu and /sys/devices/system/node.
+struct CpuInfo {
+  int cpu;
+  int core; // core_id, unique only within its socket
+  int socket; // physical_package_id
+  int node; // NUMA node
+};
+
+// Hardware threads in the affinity mask of the calling process,
+// sorted by (socket, core, cpu) so that SMT siblings are adjacent.
+// Without sysfs every CPU counts as its own core on socket 0, node 0.
+std::vector<CpuInfo> allowed_cpus();
+
+// Parses a sysfs-style CPU list such as "0-3,8,10-11". Returns false
+// if spec is malformed.
+bool parse_cpu_list(const char *spec, std::vector<int> &cpus);
+
+// Worker-to-CPU mapping chosen once per run. Worker w goes to the
+// w-th CPU of the policy's order, wrapping around (with a warning) if
+// there are more workers than CPUs in that order.
+class ThreadPinning {
+public:
+  ThreadPinning(PinPolicy policy, const std::vector<int> &cpu_list, int workers);
+
+  // Pins the calling thread as worker; a no-op for PIN_NONE.
+  void pin(int worker) const;
+  int cpu(int worker) const { return mapping.empty() ? -1 : mapping[worker]; }
+  void display() const;
+
+private:
+  PinPolicy policy;
+  std::vector<CpuInfo> cpus;
+  // CPU of each worker, empty for PIN_NONE
+  std::vector<int> mapping;
+};
+
+const char *pin_policy_name(PinPolicy policy);
+
+#endif
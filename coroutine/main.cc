@@ -0,0 +1,621 @@
+/* Copyright 2020 Stanford University
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <algorithm>
+#include <atomic>
+#include <coroutine>
+#include <memory>
+#include <mutex>
+#include <vector>
+#include <sched.h>
+#include "core.h"
+#include "core_executor.h"
+#include "timer.h"
+
+// Executor built on C++20 coroutines. Every point of a graph is one
+// coroutine that walks the timesteps, and every task co_awaits the
+// futures of its inputs (and, before overwriting a ring row, of the
+// tasks still reading it). Waiting coroutines are parked on the
+// future itself and pushed to a ready queue when it is set, so a task
+// that suspends costs one suspension and one resumption.
+//
+// Frames come from a fixed pool carved out of an arena, ready queues
+// are rings sized for every coroutine up front, and all coroutines are
+// created in reset(), so the timed region performs no allocation.
+//
+// With -elastic T:N[,T:N...] only N of the -worker threads stay active
+// from timestep T of each graph on. The rest park, and their queued
+// coroutines are left to the active workers to steal.
+
+#define FRAME_BYTES 1024
+#define FRAME_HEADER 16
+#define SPINS_BEFORE_YIELD 64
+
+// Double-ended queue of ready coroutines with a fixed capacity. A
+// coroutine sits in at most one queue at a time, so room for every
+// coroutine is enough and the ring never grows.
+struct ReadyRing {
+  std::vector<std::coroutine_handle<>> slots;
+  size_t head;
+  size_t count;
+
+  void allocate(size_t capacity)
+  {
+    slots.resize(capacity);
+    head = 0;
+    count = 0;
+  }
+
+  bool empty() const { return count == 0; }
+
+  void push_back(std::coroutine_handle<> handle)
+  {
+    if (count == slots.size()) {
+      fprintf(stderr, "error: Ready queue of %zu coroutines is full\n", slots.size());
+      abort();
+    }
+    size_t tail = head + count;
+    slots[tail < slots.size() ? tail : tail - slots.size()] = handle;
+    count++;
+  }
+
+  std::coroutine_handle<> pop_back()
+  {
+    count--;
+    size_t tail = head + count;
+    return slots[tail < slots.size() ? tail : tail - slots.size()];
+  }
+
+  std::coroutine_handle<> pop_front()
+  {
+    std::coroutine_handle<> handle = slots[head];
+    if (++head == slots.size()) head = 0;
+    count--;
+    return handle;
+  }
+};
+
+struct CoroutineWorker {
+  std::mutex lock;
+  ReadyRing ready;
+  std::vector<const char *> input_ptr;
+  std::vector<size_t> input_bytes;
+  char *scratch_ptr;
+  bool measure_overhead;
+  long suspensions;
+  long tasks;
+  double busy_seconds;
+  double kernel_seconds;
+  // With -overhead: time from a co_await suspending until its worker
+  // regains control, plus from a worker resuming a waiter until the
+  // waiter runs again; and time spent finding nothing to run.
+  double suspended_at;
+  double resumed_at;
+  double switch_seconds;
+  double idle_seconds;
+};
+
+static thread_local CoroutineWorker *current_worker = NULL;
+
+static inline double now()
+{
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+// Completion flag of one task plus the list of coroutines waiting on
+// it. state is NULL while pending with no waiters, this once set, and
+// otherwise the head of an intrusive list of awaiters living in the
+// waiters' frames.
+struct TaskFuture {
+  std::atomic<void *> state;
+
+  struct Awaiter {
+    TaskFuture &future;
+    Awaiter *next;
+    std::coroutine_handle<> handle;
+    bool suspended;
+
+    bool await_ready() const
+    {
+      return future.state.load(std::memory_order_acquire) == &future;
+    }
+
+    bool await_suspend(std::coroutine_handle<> h)
+    {
+      // Another worker may resume us as soon as the exchange below
+      // publishes this awaiter, so fill it in first.
+      handle = h;
+      suspended = true;
+      void *old = future.state.load(std::memory_order_acquire);
+      do {
+        if (old == &future) {
+          suspended = false;
+          return false; // set in the meantime, keep running
+        }
+        next = reinterpret_cast<Awaiter *>(old);
+      } while (!future.state.compare_exchange_weak(old, this, std::memory_order_release,
+                                                   std::memory_order_acquire));
+      CoroutineWorker *self = current_worker;
+      self->suspensions++;
+      if (self->measure_overhead) {
+        self->suspended_at = now();
+      }
+      return true;
+    }
+
+    void await_resume() const
+    {
+      // Resumed by whichever worker picked this coroutine up.
+      CoroutineWorker *self = current_worker;
+      if (suspended && self->measure_overhead) {
+        self->switch_seconds += now() - self->resumed_at;
+        self->resumed_at = 0;
+      }
+    }
+  };
+
+  Awaiter operator co_await() { return Awaiter{*this, NULL, NULL, false}; }
+
+  void reset() { state.store(NULL, std::memory_order_relaxed); }
+
+  // Marks the task done and makes every waiter ready on this worker.
+  void set()
+  {
+    void *old = state.exchange(this, std::memory_order_acq_rel);
+    Awaiter *waiter = reinterpret_cast<Awaiter *>(old);
+    if (!waiter) return;
+
+    CoroutineWorker *self = current_worker;
+    std::lock_guard<std::mutex> guard(self->lock);
+    while (waiter) {
+      // Read next first: the waiter may be resumed by a thief as soon
+      // as it is queued, which destroys the awaiter.
+      Awaiter *next = waiter->next;
+      self->ready.push_back(waiter->handle);
+      waiter = next;
+    }
+  }
+};
+
+// Fixed-size coroutine frames. Each block starts with a pointer back to
+// the pool so that operator delete can find it.
+struct FramePool {
+  Arena blocks;
+  std::vector<char *> free_blocks;
+
+  void allocate_pool(size_t num_frames, ArenaPlacement placement, bool huge_pages)
+  {
+    blocks.allocate(num_frames, FRAME_HEADER + FRAME_BYTES, placement, huge_pages);
+    blocks.touch(0, num_frames);
+    for (size_t i = num_frames; i > 0; i--) {
+      free_blocks.push_back(blocks.block(i - 1));
+    }
+  }
+
+  void *allocate(size_t size)
+  {
+    if (size > FRAME_BYTES) {
+      fprintf(stderr, "error: Coroutine frame of %zu bytes exceeds FRAME_BYTES (%d)\n",
+              size, FRAME_BYTES);
+      abort();
+    }
+    if (free_blocks.empty()) {
+      fprintf(stderr, "error: Coroutine frame pool exhausted\n");
+      abort();
+    }
+    char *block = free_blocks.back();
+    free_blocks.pop_back();
+    *reinterpret_cast<FramePool **>(block) = this;
+    return block + FRAME_HEADER;
+  }
+
+  static void deallocate(void *frame)
+  {
+    char *block = reinterpret_cast<char *>(frame) - FRAME_HEADER;
+    FramePool *pool = *reinterpret_cast<FramePool **>(block);
+    pool->free_blocks.push_back(block);
+  }
+};
+
+struct CoroutineGraph;
+
+struct PointCoroutine {
+  struct promise_type {
+    PointCoroutine get_return_object()
+    {
+      return PointCoroutine{std::coroutine_handle<promise_type>::from_promise(*this)};
+    }
+    std::suspend_always initial_suspend() noexcept { return {}; }
+    std::suspend_always final_suspend() noexcept { return {}; }
+    void return_void() {}
+    void unhandled_exception() { abort(); }
+
+    static void *operator new(size_t size, CoroutineGraph &cg, long point);
+    static void operator delete(void *frame, size_t) { FramePool::deallocate(frame); }
+  };
+
+  std::coroutine_handle<promise_type> handle;
+};
+
+struct CoroutineGraph {
+  TaskGraph graph;
+  GraphIndex index;
+  long nb_fields;
+  Arena outputs;
+  FramePool frames;
+  std::unique_ptr<TaskFuture[]> futures;
+  std::vector<std::coroutine_handle<>> coroutines;
+  std::atomic<long> remaining;
+  std::unique_ptr<ElasticWorkers> elastic; // with -elastic
+
+  CoroutineGraph(const TaskGraph &graph, ArenaPlacement placement, bool huge_pages)
+    : graph(graph)
+    , index(graph)
+    , nb_fields(std::min(std::max<long>(graph.nb_fields, 2), graph.timesteps))
+    , futures(new TaskFuture[graph.timesteps * graph.max_width])
+    , remaining(0)
+  {
+    outputs.allocate(nb_fields * index.width, graph.max_output_bytes(), placement, huge_pages);
+    outputs.touch(0, outputs.num_blocks());
+    frames.allocate_pool(index.width, placement, huge_pages);
+  }
+
+  char *output(long timestep, long point) const
+  {
+    return outputs.block((timestep % nb_fields) * index.width + point);
+  }
+
+  TaskFuture &future(long timestep, long point) const
+  {
+    return futures[timestep * index.width + point];
+  }
+
+  long prev_writer(long timestep, long point) const
+  {
+    for (long t = timestep - nb_fields; t >= 0; t -= nb_fields) {
+      if (index.valid(t, point)) return t;
+    }
+    return -1;
+  }
+};
+
+void *PointCoroutine::promise_type::operator new(size_t size, CoroutineGraph &cg, long point)
+{
+  return cg.frames.allocate(size);
+}
+
+static PointCoroutine run_point(CoroutineGraph &cg, long point)
+{
+  const GraphIndex &index = cg.index;
+  for (long t = 0; t < index.timesteps; t++) {
+    if (!index.valid(t, point)) continue;
+
+    // Inputs from the previous timestep.
+    if (t > 0) {
+      size_t idx = index.dep_index(t, point);
+      for (size_t i = index.dep_start[idx]; i < index.dep_start[idx + 1]; i++) {
+        std::pair<long, long> deps = index.clip(t - 1, index.dep_spans[i]);
+        for (long dep = deps.first; dep <= deps.second; dep++) {
+          co_await cg.future(t - 1, dep);
+        }
+      }
+    }
+
+    // Readers of the previous occupant of this ring row.
+    long prev = cg.prev_writer(t, point);
+    if (prev >= 0 && prev + 1 < index.timesteps) {
+      size_t ridx = index.dep_index(prev + 1, point);
+      for (size_t i = index.rdep_start[ridx]; i < index.rdep_start[ridx + 1]; i++) {
+        std::pair<long, long> consumers = index.clip(prev + 1, index.rdep_spans[i]);
+        for (long consumer = consumers.first; consumer <= consumers.second; consumer++) {
+          co_await cg.future(prev + 1, consumer);
+        }
+      }
+    }
+
+    if (cg.elastic) {
+      cg.elastic->reached(t);
+    }
+
+    // The coroutine may have moved to another worker while suspended.
+    CoroutineWorker *self = current_worker;
+    self->tasks++;
+    double start = self->measure_overhead ? now() : 0;
+    execute_indexed(cg.graph, index, t, point,
+                    [&cg](long timestep, long p) { return cg.output(timestep, p); },
+                    self->input_ptr.data(), self->input_bytes.data(), self->scratch_ptr);
+    if (self->measure_overhead) {
+      self->kernel_seconds += now() - start;
+    }
+    cg.future(t, point).set();
+  }
+  if (cg.remaining.fetch_sub(1, std::memory_order_acq_rel) == 1 && cg.elastic) {
+    cg.elastic->release();
+  }
+}
+
+struct CoroutineApp : public App {
+  CoroutineApp(int argc, char **argv);
+  ~CoroutineApp();
+  void execute_main_loop();
+private:
+  static void run_worker(int worker, void *arg);
+  static void touch_worker(int worker, void *arg);
+  void worker_loop(int worker);
+  bool find_ready(int worker, std::coroutine_handle<> &handle);
+  void reset(CoroutineGraph &cg);
+private:
+  int nb_workers;
+  bool measure_overhead;
+  std::unique_ptr<ThreadPinning> pinning;
+  WorkerPool *pool;
+  std::vector<std::unique_ptr<CoroutineWorker>> workers;
+  std::vector<std::unique_ptr<CoroutineGraph>> state;
+  CoroutineGraph *current;
+  Arena scratch;
+  size_t scratch_bytes;
+};
+
+CoroutineApp::CoroutineApp(int argc, char **argv)
+  : App(argc, argv)
+  , nb_workers(1)
+  , measure_overhead(false)
+  , pool(NULL)
+  , current(NULL)
+  , scratch_bytes(0)
+{
+  use_min_fields();
+
+  const char *elastic_spec = NULL;
+  for (int i = 1; i < argc; i++) {
+    if (!strcmp(argv[i], "-worker") && i + 1 < argc) {
+      nb_workers = atol(argv[++i]);
+      if (nb_workers <= 0) {
+        fprintf(stderr, "error: Invalid flag \"-worker %d\" must be > 0\n", nb_workers);
+        abort();
+      }
+    }
+    // same as -pin none
+    if (!strcmp(argv[i], "-no-pin")) {
+      pin_policy = PIN_NONE;
+    }
+    if (!strcmp(argv[i], "-overhead")) {
+      measure_overhead = true;
+    }
+    if (!strcmp(argv[i], "-elastic") && i + 1 < argc) {
+      elastic_spec = argv[++i];
+    }
+  }
+
+  size_t max_inputs = 0;
+  size_t num_coroutines = 0;
+  for (auto g : graphs) {
+    state.emplace_back(new CoroutineGraph(g, placement, huge_pages));
+    max_inputs = std::max(max_inputs, state.back()->index.max_inputs);
+    num_coroutines += state.back()->index.width;
+    scratch_bytes = std::max(scratch_bytes, g.scratch_bytes_per_task);
+  }
+  if (elastic_spec) {
+    ElasticWorkers::Schedule schedule = ElasticWorkers::parse_schedule(elastic_spec, nb_workers);
+    for (auto &cg : state) {
+      cg->elastic.reset(new ElasticWorkers(nb_workers, schedule, cg->graph.timesteps));
+    }
+  }
+
+  pinning.reset(new ThreadPinning(pin_policy, pin_cpus, nb_workers));
+  pool = new WorkerPool(nb_workers, pinning.get());
+  scratch.allocate(nb_workers, scratch_bytes, placement, huge_pages);
+  for (int worker = 0; worker < nb_workers; worker++) {
+    workers.emplace_back(new CoroutineWorker);
+    CoroutineWorker *w = workers.back().get();
+    w->ready.allocate(num_coroutines);
+    w->input_ptr.resize(max_inputs);
+    w->input_bytes.resize(max_inputs);
+    w->scratch_ptr = scratch.block(worker);
+    w->measure_overhead = measure_overhead;
+    w->suspensions = 0;
+    w->tasks = 0;
+    w->busy_seconds = 0;
+    w->kernel_seconds = 0;
+    w->suspended_at = 0;
+    w->resumed_at = 0;
+    w->switch_seconds = 0;
+    w->idle_seconds = 0;
+  }
+  pool->run(touch_worker, this);
+}
+
+CoroutineApp::~CoroutineApp()
+{
+  for (auto &cg : state) {
+    for (auto handle : cg->coroutines) {
+      handle.destroy();
+    }
+  }
+  delete pool;
+}
+
+void CoroutineApp::touch_worker(int worker, void *arg)
+{
+  CoroutineApp *self = reinterpret_cast<CoroutineApp *>(arg);
+  self->scratch.touch(worker, 1);
+  TaskGraph::prepare_scratch(self->workers[worker]->scratch_ptr, self->scratch_bytes);
+}
+
+void CoroutineApp::reset(CoroutineGraph &cg)
+{
+  for (auto handle : cg.coroutines) {
+    handle.destroy();
+  }
+  cg.coroutines.clear();
+
+  long num_tasks = cg.graph.timesteps * cg.index.width;
+  for (long i = 0; i < num_tasks; i++) {
+    cg.futures[i].reset();
+  }
+
+  // Each worker starts with a contiguous block of points.
+  for (long point = 0; point < cg.index.width; point++) {
+    std::coroutine_handle<> handle = run_point(cg, point).handle;
+    cg.coroutines.push_back(handle);
+    workers[point * nb_workers / cg.index.width]->ready.push_back(handle);
+  }
+  cg.remaining.store(cg.index.width, std::memory_order_release);
+}
+
+void CoroutineApp::run_worker(int worker, void *arg)
+{
+  reinterpret_cast<CoroutineApp *>(arg)->worker_loop(worker);
+}
+
+bool CoroutineApp::find_ready(int worker, std::coroutine_handle<> &handle)
+{
+  // Newest first from our own queue, oldest first from others.
+  {
+    CoroutineWorker *self = workers[worker].get();
+    std::lock_guard<std::mutex> guard(self->lock);
+    if (!self->ready.empty()) {
+      handle = self->ready.pop_back();
+      return true;
+    }
+  }
+  for (int distance = 1; distance < nb_workers; distance++) {
+    CoroutineWorker *victim = workers[(worker + distance) % nb_workers].get();
+    std::lock_guard<std::mutex> guard(victim->lock);
+    if (!victim->ready.empty()) {
+      handle = victim->ready.pop_front();
+      return true;
+    }
+  }
+  return false;
+}
+
+void CoroutineApp::worker_loop(int worker)
+{
+  CoroutineWorker *self = workers[worker].get();
+  current_worker = self;
+  double start = measure_overhead ? now() : 0;
+  double idle_since = 0;
+
+  ElasticWorkers *elastic = current->elastic.get();
+  int idle = 0;
+  while (current->remaining.load(std::memory_order_acquire) > 0) {
+    if (elastic) {
+      elastic->park_if_inactive(worker);
+    }
+    std::coroutine_handle<> handle;
+    if (find_ready(worker, handle)) {
+      if (measure_overhead) {
+        double resumed = now();
+        if (idle_since > 0) {
+          self->idle_seconds += resumed - idle_since;
+          idle_since = 0;
+        }
+        self->suspended_at = 0;
+        self->resumed_at = resumed;
+        handle.resume();
+        // Back here after the coroutine suspended or finished.
+        if (self->suspended_at > 0) {
+          self->switch_seconds += now() - self->suspended_at;
+        }
+        self->resumed_at = 0;
+      } else {
+        handle.resume();
+      }
+      idle = 0;
+    } else {
+      if (measure_overhead && idle_since == 0) {
+        idle_since = now();
+      }
+      if (++idle >= SPINS_BEFORE_YIELD) {
+        sched_yield();
+        idle = 0;
+      }
+    }
+  }
+
+  if (measure_overhead) {
+    double end = now();
+    if (idle_since > 0) {
+      self->idle_seconds += end - idle_since;
+    }
+    self->busy_seconds += end - start;
+  }
+}
+
+void CoroutineApp::execute_main_loop()
+{
+  display();
+  printf("Workers: %d\n", nb_workers);
+  pinning->display();
+
+  for (auto &cg : state) {
+    reset(*cg);
+    if (cg->elastic) {
+      cg->elastic->reset();
+    }
+  }
+
+  Timer::time_start();
+  for (auto &cg : state) {
+    current = cg.get();
+    pool->run(run_worker, this);
+  }
+  double elapsed = Timer::time_end();
+  report_timing(elapsed);
+  for (auto &cg : state) {
+    if (cg->elastic) {
+      cg->elastic->report(std::vector<TaskGraph>(1, cg->graph));
+    }
+  }
+
+  long tasks = 0, suspensions = 0;
+  double busy = 0, kernel = 0, switches = 0, idle = 0;
+  for (auto &w : workers) {
+    tasks += w->tasks;
+    suspensions += w->suspensions;
+    busy += w->busy_seconds;
+    kernel += w->kernel_seconds;
+    switches += w->switch_seconds;
+    idle += w->idle_seconds;
+  }
+  printf("Coroutines:\n");
+  printf("  Tasks %ld\n", tasks);
+  printf("  Suspensions %ld (%.3f per task)\n", suspensions,
+         tasks > 0 ? double(suspensions) / tasks : 0.0);
+  if (measure_overhead && tasks > 0) {
+    // Suspend plus resume of one co_await, then what is left of the
+    // workers' time besides kernels, switches and idling: awaiting
+    // futures that are already set, queueing and stealing.
+    printf("  Switch per suspension %e seconds\n",
+           suspensions > 0 ? switches / suspensions : 0.0);
+    printf("  Overhead per task %e seconds\n", (busy - kernel - switches - idle) / tasks);
+    printf("  Idle %e seconds (%.1f%% of worker time)\n", idle,
+           busy > 0 ? 100 * idle / busy : 0.0);
+  }
+}
+
+int main(int argc, char **argv)
+{
+  CoroutineApp app(argc, argv);
+  app.execute_main_loop();
+  return 0;
+}
@@ -72,6 +72,7 @@ export USE_HPX=${USE_HPX:-$DEFAULT_FEATURES}
 export USE_CHAPEL=${USE_CHAPEL:-$DEFAULT_FEATURES}
 export USE_X10=${USE_X10:-$DEFAULT_FEATURES}
 export USE_OPENMP=${USE_OPENMP:-$DEFAULT_FEATURES}
+export USE_COROUTINE=${USE_COROUTINE:-$DEFAULT_FEATURES}
 export USE_OMPSS=${USE_OMPSS:-$DEFAULT_FEATURES}
 export USE_OMPSS2=${USE_OMPSS2:-$DEFAULT_FEATURES}
 export USE_SPARK=${USE_SPARK:-$DEFAULT_FEATURES}
@@ -2,7 +2,11 @@
 #include <assert.h>
 #include <string.h>
 #include <algorithm> 
+#include <pthread.h>
+#include <sched.h>
+#include <atomic>
 #include "core.h"
+#include "core_executor.h"
 #include "timer.h"
 
 #define VERBOSE_LEVEL 0
@@ -11,53 +15,38 @@ pthread_barrier_t mybarrier;
 
 typedef struct task_args_s {
   int tid;
-  int nb_tasks;
+  long nb_tasks;
   double *time_start;
   double *time_end;
   char *output_ptr;
   size_t output_bytes;
   char *scratch_ptr;
   size_t scratch_bytes;
+  bool first_touch;
   TaskGraph graph;
+  const ThreadPinning *pinning;
+  // with -elastic, tasks are claimed from a shared counter in timestep
+  // order instead of being split statically
+  ElasticWorkers *elastic;
+  std::atomic<long> *next_task;
+  long total_tasks;
 }task_args_t;
 
-static void bind_thread(int core_id)
-{
-  cpu_set_t cpuset;
-  CPU_ZERO(&cpuset);
-  CPU_SET(core_id, &cpuset);
-  
-  pthread_t thread = pthread_self();
-  
-  int s = pthread_setaffinity_np(thread, sizeof(cpu_set_t), &cpuset);
-  if (s != 0) {
-     printf("pthread_setaffinity_np error %d\n", s);
-  }
-  
-  cpu_set_t cpuset_valid;
-  CPU_ZERO(&cpuset_valid);
-  s = pthread_getaffinity_np(thread, sizeof(cpu_set_t), &cpuset_valid);
-  if (s != 0) {
-    printf("pthread_getaffinity_np error %d\n", s);
-  }
-  for (int i = 0; i < CPU_SETSIZE; i++) {
-    if (i == core_id) {
-      assert(CPU_ISSET(i, &cpuset_valid) == 1);
-    } else {
-      assert(CPU_ISSET(i, &cpuset_valid) == 0);
-    }
-  }
-  
- // printf("thread %d set to %d\n", core_id-1, core_id);
-}
-
 void *execute_task(void *tr)
 {
   task_args_t *task_arg = (task_args_t *)tr;
   
-  bind_thread(task_arg->tid);
+  task_arg->pinning->pin(task_arg->tid);
   
   TaskGraph g(task_arg->graph);
+
+  // Touch this worker's buffers from the worker itself so that they
+  // are placed on its NUMA node.
+  if (task_arg->first_touch) {
+    memset(task_arg->output_ptr, 0, task_arg->output_bytes);
+    memset(task_arg->scratch_ptr, 0, task_arg->scratch_bytes);
+  }
+  TaskGraph::prepare_scratch(task_arg->scratch_ptr, task_arg->scratch_bytes);
   
   if (g.kernel.type == MEMORY_BOUND) {
     assert(task_arg->scratch_ptr != NULL);
@@ -71,27 +60,42 @@ void *execute_task(void *tr)
   pthread_barrier_wait(&mybarrier);
   
   *(task_arg->time_start) = Timer::get_cur_time();
-  for (int i = 0; i < task_arg->nb_tasks; i++) {
-    g.execute_point(i%g.timesteps, task_arg->tid, task_arg->output_ptr, task_arg->output_bytes, NULL, NULL, 0, task_arg->scratch_ptr, task_arg->scratch_bytes);
+  if (task_arg->elastic) {
+    ElasticWorkers *elastic = task_arg->elastic;
+    task_arg->nb_tasks = 0;
+    while (true) {
+      elastic->park_if_inactive(task_arg->tid);
+      long i = task_arg->next_task->fetch_add(1, std::memory_order_relaxed);
+      if (i >= task_arg->total_tasks) break;
+      elastic->reached(i / g.max_width);
+      g.execute_point(i / g.max_width, i % g.max_width, task_arg->output_ptr, task_arg->output_bytes, NULL, NULL, 0, task_arg->scratch_ptr, task_arg->scratch_bytes);
+      task_arg->nb_tasks++;
+    }
+    // wake the parked workers so that they see the counter is used up
+    elastic->release();
+  } else {
+    for (long i = 0; i < task_arg->nb_tasks; i++) {
+      g.execute_point(i%g.timesteps, task_arg->tid, task_arg->output_ptr, task_arg->output_bytes, NULL, NULL, 0, task_arg->scratch_ptr, task_arg->scratch_bytes);
+    }
   }
   *(task_arg->time_end) = Timer::get_cur_time();
   
   if (g.kernel.type == COMPUTE_BOUND) {
     long long flops = count_flops_per_task(task_arg->graph, 0, 0) * task_arg->nb_tasks;
-    printf("thread #%d, nb_tasks %d, time (%p, %p), %f ms, flop/s %e\n", 
+    printf("thread #%d, nb_tasks %ld, time (%p, %p), %f ms, flop/s %e\n", 
           task_arg->tid, task_arg->nb_tasks, 
           task_arg->time_start, task_arg->time_end, (*(task_arg->time_end) - *(task_arg->time_start)) * 1e3,
           (double)flops / (*(task_arg->time_end) - *(task_arg->time_start)));
   } else if (g.kernel.type == MEMORY_BOUND) {
     long long bytes = count_bytes_per_task(task_arg->graph, 0, 0) * task_arg->nb_tasks;
-    printf("thread #%d, nb_tasks %d, time (%p, %p), %f ms, bytes %lld, bw %e MB/s\n", 
+    printf("thread #%d, nb_tasks %ld, time (%p, %p), %f ms, bytes %lld, bw %e MB/s\n", 
           task_arg->tid, task_arg->nb_tasks, 
           task_arg->time_start, task_arg->time_end, (*(task_arg->time_end) - *(task_arg->time_start)) * 1e3,
           bytes,
           ((double)bytes/1024/1024) / (*(task_arg->time_end) - *(task_arg->time_start)));
   } else if (g.kernel.type == COMPUTE_DGEMM) {
     long long flops = count_flops_per_task(task_arg->graph, 0, 0) * task_arg->nb_tasks;
-    printf("thread #%d, nb_tasks %d, time (%p, %p), %f ms, flops %lld, flop/s %e\n", 
+    printf("thread #%d, nb_tasks %ld, time (%p, %p), %f ms, flops %lld, flop/s %e\n", 
           task_arg->tid, task_arg->nb_tasks, 
           task_arg->time_start, task_arg->time_end, (*(task_arg->time_end) - *(task_arg->time_start)) * 1e3, flops, 
           (double)flops / (*(task_arg->time_end) - *(task_arg->time_start)));
@@ -107,17 +111,23 @@ private:
   void debug_printf(int verbose_level, const char *format, ...);
 private:
   size_t nb_tasks;
-  std::vector<std::vector<char> > output_buff;
-  std::vector<std::vector<char> > scratch_buff;
+  Arena output_arena;
+  Arena scratch_arena;
   char **local_buff;
   double *time_start;
   double *time_end;
   pthread_t *threads;
   int nb_workers;
+  ThreadPinning *pinning;
+  ElasticWorkers *elastic;
+  std::atomic<long> next_task;
 };
 
 KernelBenchApp::KernelBenchApp(int argc, char **argv)
   : App(argc, argv)
+  , pinning(nullptr)
+  , elastic(nullptr)
+  , next_task(0)
 {
   assert(graphs.size() == 1);
   TaskGraph &graph = graphs[0];
@@ -126,26 +136,38 @@ KernelBenchApp::KernelBenchApp(int argc, char **argv)
   
   nb_workers = 1;
   
+  const char *elastic_spec = nullptr;
+  bool pin_given = false;
   int i;
   for (i = 1; i < argc; i++) {
     if (!strcmp(argv[i], "-worker")) {
       nb_workers = atol(argv[++i]);
     }
+    if (!strcmp(argv[i], "-elastic") && i + 1 < argc) {
+      elastic_spec = argv[++i];
+    }
+    if (!strcmp(argv[i], "-pin")) {
+      pin_given = true;
+    }
+  }
+  // kernel_bench has always pinned worker i to CPU i, so keep that
+  // unless -pin says otherwise.
+  if (!pin_given) {
+    pin_policy = PIN_COMPACT;
   }
 
   nb_tasks = graph.max_width * graph.timesteps;
-  assert(nb_tasks % nb_workers == 0);
-
-  output_buff.reserve(nb_workers);
-  for (i = 0; i < nb_workers; i++) {
-    output_buff.emplace_back(graph.output_bytes_per_task, 0);
+  if (elastic_spec) {
+    elastic = new ElasticWorkers(nb_workers, ElasticWorkers::parse_schedule(elastic_spec, nb_workers),
+                                 graph.timesteps);
+  } else {
+    assert(nb_tasks % nb_workers == 0);
   }
 
-  scratch_buff.reserve(nb_workers);
-  for (i = 0; i < nb_workers; i++) {
-    scratch_buff.emplace_back(graph.scratch_bytes_per_task, 0);
-    TaskGraph::prepare_scratch(scratch_buff[i].data(), graph.scratch_bytes_per_task);
-  }
+  // one padded block per worker; each worker touches and initializes
+  // its own blocks once it has been pinned
+  output_arena.allocate(nb_workers, graph.output_bytes_per_task, placement, huge_pages);
+  scratch_arena.allocate(nb_workers, graph.scratch_bytes_per_task, placement, huge_pages);
 
   // init timer array
   time_start = nullptr;
@@ -161,8 +183,9 @@ KernelBenchApp::KernelBenchApp(int argc, char **argv)
   
   pthread_barrier_init(&mybarrier, NULL, nb_workers);
   
-  // map main thread to 0
-  bind_thread(0);
+  // the main thread shares worker 0's CPU
+  pinning = new ThreadPinning(pin_policy, pin_cpus, nb_workers);
+  pinning->pin(0);
 }
 
 KernelBenchApp::~KernelBenchApp()
@@ -176,6 +199,9 @@ KernelBenchApp::~KernelBenchApp()
     free(time_end);
     time_end = nullptr;
   }
+
+  delete elastic;
+  delete pinning;
 }
 
 void KernelBenchApp::execute_main_loop()
@@ -183,6 +209,11 @@ void KernelBenchApp::execute_main_loop()
   int i, rc;
   
   display();
+  pinning->display();
+  if (elastic) {
+    elastic->reset();
+    next_task.store(0, std::memory_order_relaxed);
+  }
 
   task_args_t *task_args = (task_args_t*)malloc(sizeof(task_args_t) * nb_workers);
   assert(task_args != nullptr);
@@ -192,12 +223,17 @@ void KernelBenchApp::execute_main_loop()
     task_args[i].tid = i;
     task_args[i].time_start = &(time_start[i]);
     task_args[i].time_end = &(time_end[i]);
-    task_args[i].output_ptr = output_buff[i].data();
-    task_args[i].output_bytes = output_buff[i].size();
-    task_args[i].scratch_ptr = scratch_buff[i].data();
-    task_args[i].scratch_bytes = scratch_buff[i].size();
+    task_args[i].output_ptr = output_arena.block(i);
+    task_args[i].output_bytes = graphs[0].output_bytes_per_task;
+    task_args[i].scratch_ptr = scratch_arena.block(i);
+    task_args[i].scratch_bytes = graphs[0].scratch_bytes_per_task;
+    task_args[i].first_touch = placement == PLACEMENT_FIRST_TOUCH;
     task_args[i].graph = graphs[0];
+    task_args[i].pinning = pinning;
     task_args[i].nb_tasks = nb_tasks/nb_workers;
+    task_args[i].elastic = elastic;
+    task_args[i].next_task = &next_task;
+    task_args[i].total_tasks = nb_tasks;
     rc = pthread_create(&threads[i], NULL, execute_task, (void *)&(task_args[i]));
     if (rc){
       debug_printf(0, "ERROR; return code from pthread_create() is %d\n", rc);
@@ -225,6 +261,9 @@ void KernelBenchApp::execute_main_loop()
   
   report_timing(time_elapsed);
   debug_printf(0, "total time (%f, %f) %f ms\n", min_time_start*1e3, max_time_end*1e3, time_elapsed * 1e3);
+  if (elastic) {
+    elastic->report(graphs);
+  }
 }
 
 void KernelBenchApp::debug_printf(int verbose_level, const char *format, ...)
@@ -0,0 +1,348 @@
+/* Copyright 2020 Stanford University
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <algorithm>
+#include <map>
+#include <string>
+#include <vector>
+#include "core.h"
+#include "core_executor.h"
+#include "timer.h"
+
+// Driver for the in-tree executors. They have no runtime of their
+// own, so they give a lower bound on the overhead any shared-memory
+// runtime can reach on the same machine.
+//
+// With -concurrent, all graphs given with -and share one executor
+// instead of running one after the other. The dataflow executor then
+// interleaves them freely; the bulk-synchronous one runs one timestep
+// of every graph between barriers.
+//
+// Each -tenant starts the options of another App. All Apps then share
+// one worker pool, each with its own dataflow executor, and
+// -tenant-policy decides which tenant a free worker serves next. Every
+// tenant also runs alone first, as its baseline.
+//
+// With -elastic T:N[,T:N...] each executor keeps only N of the
+// -worker threads active from timestep T on, parking the rest, and
+// reports how fast throughput settles after each change. Tenants
+// follow the schedule separately, and a worker that is inactive for
+// one tenant keeps serving the others.
+//
+// The dataflow executor keeps two 32-bit dependency counters for every
+// task of the graph, so the 2^31-task graphs of test_large_scale.sh
+// would need over 16 GB for those alone; that test runs -executor
+// bulk_synchronous, which has no per-task state.
+
+enum ExecutorKind {
+  EXECUTOR_DATAFLOW,
+  EXECUTOR_BULK_SYNCHRONOUS,
+};
+
+static const std::map<std::string, ExecutorKind> executor_by_name = {
+  {"dataflow", EXECUTOR_DATAFLOW},
+  {"bulk_synchronous", EXECUTOR_BULK_SYNCHRONOUS},
+};
+
+static const std::map<std::string, TenantPolicy> tenant_policy_by_name = {
+  {"fair", TENANT_FAIR_SHARE},
+  {"priority", TENANT_PRIORITY},
+};
+
+static const std::map<std::string, SchedulingPolicy> policy_by_name = {
+  {"central", SCHEDULE_CENTRAL},
+  {"random", SCHEDULE_RANDOM},
+  {"locality", SCHEDULE_LOCALITY},
+};
+
+struct NativeApp : public App {
+  NativeApp(int argc, char **argv);
+  ~NativeApp();
+  void execute_main_loop();
+private:
+  void set_elastic(const char *spec);
+  std::vector<TaskGraph> executor_graphs(size_t i) const;
+  void execute_tenants();
+private:
+  int nb_workers;
+  ThreadPinning *pinning;
+  bool concurrent;
+  ExecutorKind kind;
+  SchedulingPolicy policy;
+  TenantPolicy tenant_policy;
+  WorkerPool *pool;
+  std::vector<Executor *> executors;
+  // tenant 0 is this App
+  std::vector<App *> tenant_apps;
+  std::vector<DataflowExecutor *> tenant_executors;
+  MultiTenantExecutor *multi_tenant;
+  // one per executor when -elastic is given
+  std::vector<ElasticWorkers *> elastic;
+};
+
+NativeApp::NativeApp(int argc, char **argv)
+  : App(argc, argv)
+  , nb_workers(1)
+  , pinning(NULL)
+  , concurrent(false)
+  , kind(EXECUTOR_DATAFLOW)
+  , policy(SCHEDULE_LOCALITY)
+  , tenant_policy(TENANT_FAIR_SHARE)
+  , pool(NULL)
+  , multi_tenant(NULL)
+{
+  use_min_fields();
+
+  const char *elastic_spec = NULL;
+  for (int i = 1; i < argc; i++) {
+    if (!strcmp(argv[i], "-worker") && i + 1 < argc) {
+      nb_workers = atol(argv[++i]);
+      if (nb_workers <= 0) {
+        fprintf(stderr, "error: Invalid flag \"-worker %d\" must be > 0\n", nb_workers);
+        abort();
+      }
+    }
+    if (!strcmp(argv[i], "-executor") && i + 1 < argc) {
+      auto name = executor_by_name.find(argv[++i]);
+      if (name == executor_by_name.end()) {
+        fprintf(stderr, "error: Invalid flag \"-executor %s\"\n", argv[i]);
+        abort();
+      }
+      kind = name->second;
+    }
+    if (!strcmp(argv[i], "-policy") && i + 1 < argc) {
+      auto name = policy_by_name.find(argv[++i]);
+      if (name == policy_by_name.end()) {
+        fprintf(stderr, "error: Invalid flag \"-policy %s\"\n", argv[i]);
+        abort();
+      }
+      policy = name->second;
+    }
+    // same as -pin none
+    if (!strcmp(argv[i], "-no-pin")) {
+      pin_policy = PIN_NONE;
+    }
+    if (!strcmp(argv[i], "-concurrent")) {
+      concurrent = true;
+    }
+    if (!strcmp(argv[i], "-tenant-policy") && i + 1 < argc) {
+      auto name = tenant_policy_by_name.find(argv[++i]);
+      if (name == tenant_policy_by_name.end()) {
+        fprintf(stderr, "error: Invalid flag \"-tenant-policy %s\"\n", argv[i]);
+        abort();
+      }
+      tenant_policy = name->second;
+    }
+    if (!strcmp(argv[i], "-elastic") && i + 1 < argc) {
+      elastic_spec = argv[++i];
+    }
+  }
+
+  tenant_apps.push_back(this);
+  long next_graph_index = graphs.size();
+  for (auto &args : tenant_args(argc, argv)) {
+    App *tenant = new App(args.size(), args.data(), next_graph_index);
+    tenant->use_min_fields();
+    next_graph_index += tenant->graphs.size();
+    tenant_apps.push_back(tenant);
+  }
+  if (tenant_apps.size() > 1 && kind != EXECUTOR_DATAFLOW) {
+    fprintf(stderr, "error: Flag \"-tenant\" requires \"-executor dataflow\"\n");
+    abort();
+  }
+  // One pool serves every graph; executors build their indices and
+  // touch their buffers here, outside the timed region.
+  pinning = new ThreadPinning(pin_policy, pin_cpus, nb_workers);
+  pool = new WorkerPool(nb_workers, pinning);
+  if (tenant_apps.size() > 1) {
+    for (auto tenant : tenant_apps) {
+      tenant_executors.push_back(new DataflowExecutor(*pool, tenant->graphs, policy, placement, huge_pages));
+    }
+    multi_tenant = new MultiTenantExecutor(*pool, tenant_executors, tenant_policy);
+    if (elastic_spec) {
+      set_elastic(elastic_spec);
+    }
+    return;
+  }
+  if (concurrent) {
+    if (kind == EXECUTOR_BULK_SYNCHRONOUS) {
+      executors.push_back(new BulkSynchronousExecutor(*pool, graphs, placement, huge_pages));
+    } else {
+      executors.push_back(new DataflowExecutor(*pool, graphs, policy, placement, huge_pages));
+    }
+  } else {
+    for (auto g : graphs) {
+      if (kind == EXECUTOR_BULK_SYNCHRONOUS) {
+        executors.push_back(new BulkSynchronousExecutor(*pool, g, g.nb_fields, placement, huge_pages));
+      } else {
+        executors.push_back(new DataflowExecutor(*pool, g, policy, g.nb_fields, placement, huge_pages));
+      }
+    }
+  }
+  if (elastic_spec) {
+    set_elastic(elastic_spec);
+  }
+}
+
+void NativeApp::set_elastic(const char *spec)
+{
+  ElasticWorkers::Schedule schedule = ElasticWorkers::parse_schedule(spec, nb_workers);
+  size_t count = multi_tenant ? tenant_executors.size() : executors.size();
+  for (size_t i = 0; i < count; i++) {
+    long timesteps = 0;
+    for (auto &g : executor_graphs(i)) {
+      timesteps = std::max(timesteps, g.timesteps);
+    }
+    elastic.push_back(new ElasticWorkers(nb_workers, schedule, timesteps));
+    if (multi_tenant) {
+      tenant_executors[i]->set_elastic(elastic.back());
+    } else if (kind == EXECUTOR_BULK_SYNCHRONOUS) {
+      static_cast<BulkSynchronousExecutor *>(executors[i])->set_elastic(elastic.back());
+    } else {
+      static_cast<DataflowExecutor *>(executors[i])->set_elastic(elastic.back());
+    }
+  }
+}
+
+std::vector<TaskGraph> NativeApp::executor_graphs(size_t i) const
+{
+  if (multi_tenant) {
+    return tenant_apps[i]->graphs;
+  }
+  if (concurrent) {
+    return graphs;
+  }
+  return std::vector<TaskGraph>(1, graphs[i]);
+}
+
+NativeApp::~NativeApp()
+{
+  for (auto executor : executors) {
+    delete executor;
+  }
+  for (auto e : elastic) {
+    delete e;
+  }
+  delete multi_tenant;
+  for (auto executor : tenant_executors) {
+    delete executor;
+  }
+  for (size_t i = 1; i < tenant_apps.size(); i++) {
+    delete tenant_apps[i];
+  }
+  delete pool;
+  delete pinning;
+}
+
+void NativeApp::execute_main_loop()
+{
+  if (multi_tenant) {
+    execute_tenants();
+    return;
+  }
+
+  display();
+  printf("Workers: %d\n", nb_workers);
+  pinning->display();
+  if (concurrent) {
+    printf("Graphs: concurrent, %s\n",
+           kind == EXECUTOR_BULK_SYNCHRONOUS ? "round-robin timesteps" : "dataflow");
+  } else {
+    printf("Graphs: one after another\n");
+  }
+
+  for (auto executor : executors) {
+    executor->reset();
+  }
+  for (auto e : elastic) {
+    e->reset();
+  }
+
+  std::vector<double> completion;
+  double start = Timer::time_start();
+  for (auto executor : executors) {
+    double executor_start = Timer::get_cur_time() - start;
+    executor->execute();
+    for (double t : executor->completion_times()) {
+      completion.push_back(executor_start + t);
+    }
+  }
+  double elapsed = Timer::time_end();
+  report_timing(elapsed);
+  for (size_t i = 0; i < completion.size(); i++) {
+    printf("Graph %zu completed: %e seconds\n", i, completion[i]);
+  }
+  for (size_t i = 0; i < elastic.size(); i++) {
+    elastic[i]->report(executor_graphs(i));
+  }
+}
+
+void NativeApp::execute_tenants()
+{
+  for (size_t i = 0; i < tenant_apps.size(); i++) {
+    printf("Tenant %zu:\n", i);
+    tenant_apps[i]->display();
+  }
+  printf("Workers: %d\n", nb_workers);
+  pinning->display();
+  printf("Tenant policy: %s\n", tenant_policy == TENANT_PRIORITY ? "priority" : "fair share");
+
+  // Baseline: each tenant with the whole pool to itself.
+  std::vector<double> alone;
+  for (size_t i = 0; i < tenant_executors.size(); i++) {
+    DataflowExecutor *executor = tenant_executors[i];
+    executor->reset();
+    if (!elastic.empty()) {
+      elastic[i]->reset();
+    }
+    double start = Timer::get_cur_time();
+    executor->execute();
+    alone.push_back(Timer::get_cur_time() - start);
+  }
+
+  multi_tenant->reset();
+  for (auto e : elastic) {
+    e->reset();
+  }
+  Timer::time_start();
+  multi_tenant->execute();
+  double elapsed = Timer::time_end();
+
+  const std::vector<double> &shared = multi_tenant->completion_times();
+  for (size_t i = 0; i < tenant_apps.size(); i++) {
+    printf("Tenant %zu:\n", i);
+    tenant_apps[i]->report_timing(shared[i]);
+  }
+  printf("All tenants: %e seconds\n", elapsed);
+  for (size_t i = 0; i < tenant_apps.size(); i++) {
+    long tasks = tenant_executors[i]->num_tasks();
+    printf("Tenant %zu: alone %e s, shared %e s, slowdown %.2fx, %e tasks/s shared\n",
+           i, alone[i], shared[i], shared[i] / alone[i], tasks / shared[i]);
+  }
+  for (size_t i = 0; i < elastic.size(); i++) {
+    printf("Tenant %zu:\n", i);
+    elastic[i]->report(executor_graphs(i));
+  }
+}
+
+int main(int argc, char **argv)
+{
+  NativeApp app(argc, argv);
+  app.execute_main_loop();
+  return 0;
+}
@@ -0,0 +1,298 @@
+/* Copyright 2020 Stanford University
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sched.h>
+#include <algorithm>
+#include <atomic>
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+#include <omp.h>
+#include "core.h"
+#include "core_executor.h"
+#include "timer.h"
+
+// Worksharing counterpart of main.cc: every timestep is one
+// "omp for" over its points, so the cost of dependency-based tasking
+// can be measured against plain loops on the same machine.
+//
+// By default the implicit barrier at the end of each loop separates
+// timesteps. With -nowait the loops drop the barrier and each point
+// instead waits on per-point completion flags of the points it reads
+// from and of the readers of the row it overwrites.
+
+#define SPINS_BEFORE_YIELD 64
+
+static const std::map<std::string, omp_sched_t> schedule_by_name = {
+  {"static", omp_sched_static},
+  {"dynamic", omp_sched_dynamic},
+  {"guided", omp_sched_guided},
+};
+
+struct ForallGraph {
+  ForallGraph(const TaskGraph &graph, long nb_fields,
+              ArenaPlacement placement, bool huge_pages)
+    : graph(graph)
+    , nb_fields(nb_fields)
+    , index(graph)
+  {
+    outputs.allocate(nb_fields * index.width, graph.max_output_bytes(), placement, huge_pages);
+    done.allocate(index.width, sizeof(std::atomic<long>), placement, huge_pages);
+  }
+
+  char *output(long timestep, long point) const
+  {
+    return outputs.block((timestep % nb_fields) * index.width + point);
+  }
+
+  // Number of timesteps of point that have completed.
+  std::atomic<long> &completed(long point) const
+  {
+    return *reinterpret_cast<std::atomic<long> *>(done.block(point));
+  }
+
+  TaskGraph graph;
+  long nb_fields;
+  GraphIndex index;
+  Arena outputs;
+  Arena done;
+};
+
+struct OpenMPForallApp : public App {
+  OpenMPForallApp(int argc, char **argv);
+  void execute_main_loop();
+private:
+  void wait_completed(const ForallGraph &g, long point, long timesteps);
+  void wait_inputs(const ForallGraph &g, long t, long point);
+  void execute_point(const ForallGraph &g, long t, long point);
+private:
+  int nb_workers;
+  omp_sched_t schedule;
+  int chunk;
+  bool nowait;
+  std::unique_ptr<ThreadPinning> pinning;
+  std::vector<std::unique_ptr<ForallGraph> > forall_graphs;
+  size_t max_inputs;
+  // per thread: loops are tied, so the thread id is stable for a point
+  std::vector<std::vector<const char *> > inputs;
+  std::vector<std::vector<size_t> > sizes;
+  Arena scratch;
+};
+
+OpenMPForallApp::OpenMPForallApp(int argc, char **argv)
+  : App(argc, argv)
+  , nb_workers(1)
+  , schedule(omp_sched_static)
+  , chunk(0)
+  , nowait(false)
+  , max_inputs(1)
+{
+  use_min_fields();
+
+  for (int i = 1; i < argc; i++) {
+    if (!strcmp(argv[i], "-worker") && i + 1 < argc) {
+      nb_workers = atol(argv[++i]);
+      if (nb_workers <= 0) {
+        fprintf(stderr, "error: Invalid flag \"-worker %d\" must be > 0\n", nb_workers);
+        abort();
+      }
+    }
+    if (!strcmp(argv[i], "-schedule") && i + 1 < argc) {
+      auto name = schedule_by_name.find(argv[++i]);
+      if (name == schedule_by_name.end()) {
+        fprintf(stderr, "error: Invalid flag \"-schedule %s\"\n", argv[i]);
+        abort();
+      }
+      schedule = name->second;
+    }
+    if (!strcmp(argv[i], "-chunk") && i + 1 < argc) {
+      chunk = atol(argv[++i]);
+      if (chunk < 0) {
+        fprintf(stderr, "error: Invalid flag \"-chunk %d\" must be >= 0\n", chunk);
+        abort();
+      }
+    }
+    if (!strcmp(argv[i], "-nowait")) {
+      nowait = true;
+    }
+  }
+
+  // Without the barrier a thread may run ahead into later loops; only
+  // a static schedule guarantees that the iterations it waits for are
+  // owned by threads that will get to them.
+  if (nowait && schedule != omp_sched_static) {
+    fprintf(stderr, "error: Flag \"-nowait\" requires \"-schedule static\"\n");
+    abort();
+  }
+
+  omp_set_num_threads(nb_workers);
+  omp_set_schedule(schedule, chunk);
+  pinning.reset(new ThreadPinning(pin_policy, pin_cpus, nb_workers));
+
+  size_t max_scratch_bytes = 0;
+  for (auto g : graphs) {
+    // A timestep reads the row of the previous one, so it can never
+    // write in place.
+    long nb_fields = std::max<long>(g.nb_fields, 2);
+    forall_graphs.emplace_back(new ForallGraph(g, nb_fields, placement, huge_pages));
+    max_inputs = std::max(max_inputs, forall_graphs.back()->index.max_inputs);
+    max_scratch_bytes = std::max(max_scratch_bytes, g.scratch_bytes_per_task);
+  }
+
+  inputs.resize(nb_workers, std::vector<const char *>(max_inputs));
+  sizes.resize(nb_workers, std::vector<size_t>(max_inputs));
+  scratch.allocate(nb_workers, max_scratch_bytes, placement, huge_pages);
+
+  // Touch each point's outputs and flag through the same schedule as
+  // the timed loops, so that with a static schedule the pages land
+  // near the thread that uses them.
+  #pragma omp parallel
+  {
+    int tid = omp_get_thread_num();
+    pinning->pin(tid);
+    scratch.touch(tid, 1);
+    TaskGraph::prepare_scratch(scratch.block(tid), max_scratch_bytes);
+
+    for (auto &g : forall_graphs) {
+      #pragma omp for schedule(runtime)
+      for (long point = 0; point < g->index.width; point++) {
+        for (long field = 0; field < g->nb_fields; field++) {
+          g->outputs.touch(field * g->index.width + point, 1);
+        }
+        g->done.touch(point, 1);
+      }
+    }
+  }
+}
+
+void OpenMPForallApp::wait_completed(const ForallGraph &g, long point, long timesteps)
+{
+  std::atomic<long> &flag = g.completed(point);
+  int spins = 0;
+  while (flag.load(std::memory_order_acquire) < timesteps) {
+    if (++spins >= SPINS_BEFORE_YIELD) {
+      sched_yield();
+      spins = 0;
+    }
+  }
+}
+
+void OpenMPForallApp::wait_inputs(const ForallGraph &g, long t, long point)
+{
+  const GraphIndex &index = g.index;
+
+  // Completion flags only move forward if each point runs its
+  // timesteps in order, which a different thread may not do when the
+  // width changes between loops.
+  for (long prev = t - 1; prev >= 0; prev--) {
+    if (index.valid(prev, point)) {
+      wait_completed(g, point, prev + 1);
+      break;
+    }
+  }
+
+  if (t > 0) {
+    size_t idx = index.dep_index(t, point);
+    for (size_t i = index.dep_start[idx]; i < index.dep_start[idx + 1]; i++) {
+      std::pair<long, long> deps = index.clip(t - 1, index.dep_spans[i]);
+      for (long dep = deps.first; dep <= deps.second; dep++) {
+        wait_completed(g, dep, t);
+      }
+    }
+  }
+
+  // Every reader of the previous occupant of the output row must be
+  // done before it is overwritten.
+  long prev = t - g.nb_fields;
+  while (prev >= 0 && !index.valid(prev, point)) {
+    prev -= g.nb_fields;
+  }
+  if (prev >= 0 && prev + 1 < index.timesteps) {
+    size_t idx = index.dep_index(prev + 1, point);
+    for (size_t i = index.rdep_start[idx]; i < index.rdep_start[idx + 1]; i++) {
+      std::pair<long, long> readers = index.clip(prev + 1, index.rdep_spans[i]);
+      for (long reader = readers.first; reader <= readers.second; reader++) {
+        wait_completed(g, reader, prev + 2);
+      }
+    }
+  }
+}
+
+void OpenMPForallApp::execute_point(const ForallGraph &g, long t, long point)
+{
+  int tid = omp_get_thread_num();
+  execute_indexed(g.graph, g.index, t, point,
+                  [&](long timestep, long p) { return g.output(timestep, p); },
+                  inputs[tid].data(), sizes[tid].data(), scratch.block(tid));
+}
+
+void OpenMPForallApp::execute_main_loop()
+{
+  display();
+  const char *schedule_name = "static";
+  for (auto &s : schedule_by_name) {
+    if (s.second == schedule) schedule_name = s.first.c_str();
+  }
+  printf("Workers: %d\n", nb_workers);
+  pinning->display();
+  printf("Schedule: %s, chunk %d, %s\n", schedule_name, chunk,
+         nowait ? "point-wise flags" : "barrier per timestep");
+
+  for (auto &g : forall_graphs) {
+    for (long point = 0; point < g->index.width; point++) {
+      g->completed(point).store(0, std::memory_order_relaxed);
+    }
+  }
+
+  Timer::time_start();
+
+  #pragma omp parallel
+  {
+    for (auto &g : forall_graphs) {
+      const GraphIndex &index = g->index;
+      for (long t = 0; t < index.timesteps; t++) {
+        long first = index.row_offset[t];
+        long last = first + index.row_width[t];
+        if (nowait) {
+          #pragma omp for schedule(runtime) nowait
+          for (long point = first; point < last; point++) {
+            wait_inputs(*g, t, point);
+            execute_point(*g, t, point);
+            g->completed(point).store(t + 1, std::memory_order_release);
+          }
+        } else {
+          #pragma omp for schedule(runtime)
+          for (long point = first; point < last; point++) {
+            execute_point(*g, t, point);
+          }
+        }
+      }
+    }
+  }
+
+  double elapsed = Timer::time_end();
+  report_timing(elapsed);
+}
+
+int main(int argc, char **argv)
+{
+  OpenMPForallApp app(argc, argv);
+  app.execute_main_loop();
+  return 0;
+}
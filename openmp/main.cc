@@ -19,6 +19,7 @@
 #include <algorithm> 
 #include <unistd.h>
 #include <omp.h>
+#include <sys/resource.h>
 #include "core.h"
 #include "timer.h"
 
@@ -30,45 +31,81 @@
 
 typedef struct tile_s {
   float dep;
+  long point;
   char *output_buff;
 }tile_t;
 
-typedef struct payload_s {
-  int x;
-  int y;
-  TaskGraph graph;
-}payload_t;
+typedef TaskDescriptor payload_t;
 
 typedef struct task_args_s {
-  int x;
-  int y;
+  long x;
+  long y;
 }task_args_t;
 
 typedef struct matrix_s {
   tile_t *data;
-  int M;
-  int N;
+  long M;
+  long N;
 }matrix_t;
 
-char **extra_local_memory;
+// Tasks are untied and may move between threads, so each task takes
+// its own scratch buffer instead of using one per thread.
+ScratchPool scratch_pool;
+
+// Input arrays of task_generic, sized for the widest task. They come
+// from a pool for the same reason as scratch: a buffer per thread is
+// not safe for untied tasks.
+typedef struct generic_inputs_s {
+  std::pair<long, long> *deps;
+  const char **input_ptr;
+  size_t *input_bytes;
+}generic_inputs_t;
+
+ScratchPool generic_pool;
+size_t generic_max_deps = 0;
+size_t generic_max_inputs = 0;
+
+// Each pool buffer holds the three arrays back to back.
+static inline generic_inputs_t generic_inputs(char *buffer)
+{
+  generic_inputs_t in;
+  in.deps = reinterpret_cast<std::pair<long, long> *>(buffer);
+  in.input_ptr = reinterpret_cast<const char **>(in.deps + generic_max_deps);
+  in.input_bytes = reinterpret_cast<size_t *>(in.input_ptr + generic_max_inputs);
+  return in;
+}
+
+matrix_t *matrix = NULL;
+
+// priority clause of the tasks being created; nonzero only between
+// tenants with -tenant-policy priority
+int task_priority = 0;
+
+// Passes the part of the producer's output that belongs to this
+// consumer. Only edge distributions split an output between consumers.
+static inline void add_tile_input(TaskArgs &args, const TaskGraph &graph,
+                                  const tile_t *tile_in, payload_t payload)
+{
+  long t = payload.timestep - 1;
+  args.add_input(tile_in->output_buff + graph.output_field_offset(t, tile_in->point, payload.point),
+                 graph.output_field_bytes(t, tile_in->point, payload.point));
+}
 
 static inline void task1(tile_t *tile_out, payload_t payload)
 {
   int tid = omp_get_thread_num();
 #if defined (USE_CORE_VERIFICATION)    
-  TaskGraph graph = payload.graph;
-  char *output_ptr = (char*)tile_out->output_buff;
-  size_t output_bytes= graph.output_bytes_per_task;
-  std::vector<const char *> input_ptrs;
-  std::vector<size_t> input_bytes;
-  input_ptrs.push_back((char*)tile_out->output_buff);
-  input_bytes.push_back(graph.output_bytes_per_task);
-  
-  graph.execute_point(payload.y, payload.x, output_ptr, output_bytes,
-                      input_ptrs.data(), input_bytes.data(), input_ptrs.size(), extra_local_memory[tid], graph.scratch_bytes_per_task);
+  const TaskGraph &graph = registered_task_graph(payload.graph_id);
+  char *scratch = scratch_pool.acquire(tid);
+  TaskArgs args;
+  args.reset(tile_out->output_buff, graph.task_output_bytes(payload.timestep, payload.point),
+             scratch, graph.scratch_bytes_per_task);
+  args.add_input(tile_out->output_buff, args.output_bytes);
+  execute_point(payload, args);
+  scratch_pool.release(omp_get_thread_num(), scratch);
 #else  
   tile_out->dep = 0;
-  printf("Task1 tid %d, x %d, y %d, out %f\n", tid, payload.x, payload.y, tile_out->dep);
+  printf("Task1 tid %d, x %ld, y %ld, out %f\n", tid, payload.point, payload.timestep, tile_out->dep);
 #endif  
 }
 
@@ -76,19 +113,17 @@ static inline void task2(tile_t *tile_out, tile_t *tile_in1, payload_t payload)
 {
   int tid = omp_get_thread_num();
 #if defined (USE_CORE_VERIFICATION)    
-  TaskGraph graph = payload.graph;
-  char *output_ptr = (char*)tile_out->output_buff;
-  size_t output_bytes= graph.output_bytes_per_task;
-  std::vector<const char *> input_ptrs;
-  std::vector<size_t> input_bytes;
-  input_ptrs.push_back((char*)tile_in1->output_buff);
-  input_bytes.push_back(graph.output_bytes_per_task);
-  
-  graph.execute_point(payload.y, payload.x, output_ptr, output_bytes,
-                      input_ptrs.data(), input_bytes.data(), input_ptrs.size(), extra_local_memory[tid], graph.scratch_bytes_per_task);
+  const TaskGraph &graph = registered_task_graph(payload.graph_id);
+  char *scratch = scratch_pool.acquire(tid);
+  TaskArgs args;
+  args.reset(tile_out->output_buff, graph.task_output_bytes(payload.timestep, payload.point),
+             scratch, graph.scratch_bytes_per_task);
+  add_tile_input(args, graph, tile_in1, payload);
+  execute_point(payload, args);
+  scratch_pool.release(omp_get_thread_num(), scratch);
 #else  
   tile_out->dep = tile_in1->dep + 1;
-  printf("Task2 tid %d, x %d, y %d, out %f, in1 %f\n", tid, payload.x, payload.y, tile_out->dep,tile_in1->dep);
+  printf("Task2 tid %d, x %ld, y %ld, out %f, in1 %f\n", tid, payload.point, payload.timestep, tile_out->dep,tile_in1->dep);
 #endif
 }
 
@@ -96,21 +131,18 @@ static inline void task3(tile_t *tile_out, tile_t *tile_in1, tile_t *tile_in2, p
 {
   int tid = omp_get_thread_num();
 #if defined (USE_CORE_VERIFICATION)    
-  TaskGraph graph = payload.graph;
-  char *output_ptr = (char*)tile_out->output_buff;
-  size_t output_bytes= graph.output_bytes_per_task;
-  std::vector<const char *> input_ptrs;
-  std::vector<size_t> input_bytes;
-  input_ptrs.push_back((char*)tile_in1->output_buff);
-  input_bytes.push_back(graph.output_bytes_per_task);
-  input_ptrs.push_back((char*)tile_in2->output_buff);
-  input_bytes.push_back(graph.output_bytes_per_task);
-
-  graph.execute_point(payload.y, payload.x, output_ptr, output_bytes,
-                     input_ptrs.data(), input_bytes.data(), input_ptrs.size(), extra_local_memory[tid], graph.scratch_bytes_per_task);
+  const TaskGraph &graph = registered_task_graph(payload.graph_id);
+  char *scratch = scratch_pool.acquire(tid);
+  TaskArgs args;
+  args.reset(tile_out->output_buff, graph.task_output_bytes(payload.timestep, payload.point),
+             scratch, graph.scratch_bytes_per_task);
+  add_tile_input(args, graph, tile_in1, payload);
+  add_tile_input(args, graph, tile_in2, payload);
+  execute_point(payload, args);
+  scratch_pool.release(omp_get_thread_num(), scratch);
 #else  
   tile_out->dep = tile_in1->dep + tile_in2->dep + 1;
-  printf("Task3 tid %d, x %d, y %d, out %f, in1 %f, in2 %f\n", tid, payload.x, payload.y, tile_out->dep,tile_in1->dep, tile_in2->dep);
+  printf("Task3 tid %d, x %ld, y %ld, out %f, in1 %f, in2 %f\n", tid, payload.point, payload.timestep, tile_out->dep,tile_in1->dep, tile_in2->dep);
 #endif
 }
 
@@ -118,23 +150,19 @@ static inline void task4(tile_t *tile_out, tile_t *tile_in1, tile_t *tile_in2, t
 {
   int tid = omp_get_thread_num();
 #if defined (USE_CORE_VERIFICATION)    
-  TaskGraph graph = payload.graph;
-  char *output_ptr = (char*)tile_out->output_buff;
-  size_t output_bytes= graph.output_bytes_per_task;
-  std::vector<const char *> input_ptrs;
-  std::vector<size_t> input_bytes;
-  input_ptrs.push_back((char*)tile_in1->output_buff);
-  input_bytes.push_back(graph.output_bytes_per_task);
-  input_ptrs.push_back((char*)tile_in2->output_buff);
-  input_bytes.push_back(graph.output_bytes_per_task);
-  input_ptrs.push_back((char*)tile_in3->output_buff);
-  input_bytes.push_back(graph.output_bytes_per_task);
-
-  graph.execute_point(payload.y, payload.x, output_ptr, output_bytes,
-                      input_ptrs.data(), input_bytes.data(), input_ptrs.size(), extra_local_memory[tid], graph.scratch_bytes_per_task);
+  const TaskGraph &graph = registered_task_graph(payload.graph_id);
+  char *scratch = scratch_pool.acquire(tid);
+  TaskArgs args;
+  args.reset(tile_out->output_buff, graph.task_output_bytes(payload.timestep, payload.point),
+             scratch, graph.scratch_bytes_per_task);
+  add_tile_input(args, graph, tile_in1, payload);
+  add_tile_input(args, graph, tile_in2, payload);
+  add_tile_input(args, graph, tile_in3, payload);
+  execute_point(payload, args);
+  scratch_pool.release(omp_get_thread_num(), scratch);
 #else
   tile_out->dep = tile_in1->dep + tile_in2->dep + tile_in3->dep + 1;
-  printf("Task4 tid %d, x %d, y %d, out %f, in1 %f, in2 %f, in3 %f\n", tid, payload.x, payload.y, tile_out->dep,tile_in1->dep, tile_in2->dep, tile_in3->dep);
+  printf("Task4 tid %d, x %ld, y %ld, out %f, in1 %f, in2 %f, in3 %f\n", tid, payload.point, payload.timestep, tile_out->dep,tile_in1->dep, tile_in2->dep, tile_in3->dep);
 #endif
 }
 
@@ -142,25 +170,20 @@ static inline void task5(tile_t *tile_out, tile_t *tile_in1, tile_t *tile_in2, t
 {
   int tid = omp_get_thread_num();
 #if defined (USE_CORE_VERIFICATION)    
-  TaskGraph graph = payload.graph;
-  char *output_ptr = (char*)tile_out->output_buff;
-  size_t output_bytes= graph.output_bytes_per_task;
-  std::vector<const char *> input_ptrs;
-  std::vector<size_t> input_bytes;
-  input_ptrs.push_back((char*)tile_in1->output_buff);
-  input_bytes.push_back(graph.output_bytes_per_task);
-  input_ptrs.push_back((char*)tile_in2->output_buff);
-  input_bytes.push_back(graph.output_bytes_per_task);
-  input_ptrs.push_back((char*)tile_in3->output_buff);
-  input_bytes.push_back(graph.output_bytes_per_task);
-  input_ptrs.push_back((char*)tile_in4->output_buff);
-  input_bytes.push_back(graph.output_bytes_per_task);
-
-  graph.execute_point(payload.y, payload.x, output_ptr, output_bytes,
-                      input_ptrs.data(), input_bytes.data(), input_ptrs.size(), extra_local_memory[tid], graph.scratch_bytes_per_task);
+  const TaskGraph &graph = registered_task_graph(payload.graph_id);
+  char *scratch = scratch_pool.acquire(tid);
+  TaskArgs args;
+  args.reset(tile_out->output_buff, graph.task_output_bytes(payload.timestep, payload.point),
+             scratch, graph.scratch_bytes_per_task);
+  add_tile_input(args, graph, tile_in1, payload);
+  add_tile_input(args, graph, tile_in2, payload);
+  add_tile_input(args, graph, tile_in3, payload);
+  add_tile_input(args, graph, tile_in4, payload);
+  execute_point(payload, args);
+  scratch_pool.release(omp_get_thread_num(), scratch);
 #else
   tile_out->dep = tile_in1->dep + tile_in2->dep + tile_in3->dep + tile_in4->dep + 1;
-  printf("Task5 tid %d, x %d, y %d, out %f, in1 %f, in2 %f, in3 %f, in4 %f\n", tid, payload.x, payload.y, tile_out->dep,tile_in1->dep, tile_in2->dep, tile_in3->dep, tile_in4->dep);
+  printf("Task5 tid %d, x %ld, y %ld, out %f, in1 %f, in2 %f, in3 %f, in4 %f\n", tid, payload.point, payload.timestep, tile_out->dep,tile_in1->dep, tile_in2->dep, tile_in3->dep, tile_in4->dep);
 #endif
 }
 
@@ -168,27 +191,21 @@ static inline void task6(tile_t *tile_out, tile_t *tile_in1, tile_t *tile_in2, t
 {
   int tid = omp_get_thread_num();
 #if defined (USE_CORE_VERIFICATION)    
-  TaskGraph graph = payload.graph;
-  char *output_ptr = (char*)tile_out->output_buff;
-  size_t output_bytes= graph.output_bytes_per_task;
-  std::vector<const char *> input_ptrs;
-  std::vector<size_t> input_bytes;
-  input_ptrs.push_back((char*)tile_in1->output_buff);
-  input_bytes.push_back(graph.output_bytes_per_task);
-  input_ptrs.push_back((char*)tile_in2->output_buff);
-  input_bytes.push_back(graph.output_bytes_per_task);
-  input_ptrs.push_back((char*)tile_in3->output_buff);
-  input_bytes.push_back(graph.output_bytes_per_task);
-  input_ptrs.push_back((char*)tile_in4->output_buff);
-  input_bytes.push_back(graph.output_bytes_per_task);
-  input_ptrs.push_back((char*)tile_in5->output_buff);
-  input_bytes.push_back(graph.output_bytes_per_task);
-
-  graph.execute_point(payload.y, payload.x, output_ptr, output_bytes,
-                      input_ptrs.data(), input_bytes.data(), input_ptrs.size(), extra_local_memory[tid], graph.scratch_bytes_per_task);
+  const TaskGraph &graph = registered_task_graph(payload.graph_id);
+  char *scratch = scratch_pool.acquire(tid);
+  TaskArgs args;
+  args.reset(tile_out->output_buff, graph.task_output_bytes(payload.timestep, payload.point),
+             scratch, graph.scratch_bytes_per_task);
+  add_tile_input(args, graph, tile_in1, payload);
+  add_tile_input(args, graph, tile_in2, payload);
+  add_tile_input(args, graph, tile_in3, payload);
+  add_tile_input(args, graph, tile_in4, payload);
+  add_tile_input(args, graph, tile_in5, payload);
+  execute_point(payload, args);
+  scratch_pool.release(omp_get_thread_num(), scratch);
 #else
   tile_out->dep = tile_in1->dep + tile_in2->dep + tile_in3->dep + tile_in4->dep + tile_in5->dep + 1;
-  printf("Task6 tid %d, x %d, y %d, out %f, in1 %f, in2 %f, in3 %f, in4 %f, in5 %f\n", tid, payload.x, payload.y, tile_out->dep,tile_in1->dep, tile_in2->dep, tile_in3->dep, tile_in4->dep, tile_in5->dep);
+  printf("Task6 tid %d, x %ld, y %ld, out %f, in1 %f, in2 %f, in3 %f, in4 %f, in5 %f\n", tid, payload.point, payload.timestep, tile_out->dep,tile_in1->dep, tile_in2->dep, tile_in3->dep, tile_in4->dep, tile_in5->dep);
 #endif
 }
 
@@ -196,30 +213,23 @@ static inline void task7(tile_t *tile_out, tile_t *tile_in1, tile_t *tile_in2, t
 {
   int tid = omp_get_thread_num();
 #if defined (USE_CORE_VERIFICATION)    
-  TaskGraph graph = payload.graph;
-  char *output_ptr = (char*)tile_out->output_buff;
-  size_t output_bytes= graph.output_bytes_per_task;
-  std::vector<const char *> input_ptrs;
-  std::vector<size_t> input_bytes;
-  input_ptrs.push_back((char*)tile_in1->output_buff);
-  input_bytes.push_back(graph.output_bytes_per_task);
-  input_ptrs.push_back((char*)tile_in2->output_buff);
-  input_bytes.push_back(graph.output_bytes_per_task);
-  input_ptrs.push_back((char*)tile_in3->output_buff);
-  input_bytes.push_back(graph.output_bytes_per_task);
-  input_ptrs.push_back((char*)tile_in4->output_buff);
-  input_bytes.push_back(graph.output_bytes_per_task);
-  input_ptrs.push_back((char*)tile_in5->output_buff);
-  input_bytes.push_back(graph.output_bytes_per_task);
-  input_ptrs.push_back((char*)tile_in6->output_buff);
-  input_bytes.push_back(graph.output_bytes_per_task);
-
-  graph.execute_point(payload.y, payload.x, output_ptr, output_bytes,
-                      input_ptrs.data(), input_bytes.data(), input_ptrs.size(), extra_local_memory[tid], graph.scratch_bytes_per_task);
+  const TaskGraph &graph = registered_task_graph(payload.graph_id);
+  char *scratch = scratch_pool.acquire(tid);
+  TaskArgs args;
+  args.reset(tile_out->output_buff, graph.task_output_bytes(payload.timestep, payload.point),
+             scratch, graph.scratch_bytes_per_task);
+  add_tile_input(args, graph, tile_in1, payload);
+  add_tile_input(args, graph, tile_in2, payload);
+  add_tile_input(args, graph, tile_in3, payload);
+  add_tile_input(args, graph, tile_in4, payload);
+  add_tile_input(args, graph, tile_in5, payload);
+  add_tile_input(args, graph, tile_in6, payload);
+  execute_point(payload, args);
+  scratch_pool.release(omp_get_thread_num(), scratch);
 #else
   tile_out->dep = tile_in1->dep + tile_in2->dep + tile_in3->dep + tile_in4->dep + tile_in5->dep + tile_in6->dep + 1;
-  printf("Task7 tid %d, x %d, y %d, out %f, in1 %f, in2 %f, in3 %f, in4 %f, in5 %f, in6 %f\n", 
-    tid, payload.x, payload.y, tile_out->dep,tile_in1->dep, tile_in2->dep, tile_in3->dep, tile_in4->dep, tile_in5->dep, tile_in6->dep);
+  printf("Task7 tid %d, x %ld, y %ld, out %f, in1 %f, in2 %f, in3 %f, in4 %f, in5 %f, in6 %f\n", 
+    tid, payload.point, payload.timestep, tile_out->dep,tile_in1->dep, tile_in2->dep, tile_in3->dep, tile_in4->dep, tile_in5->dep, tile_in6->dep);
 #endif
 }
 
@@ -227,32 +237,24 @@ static inline void task8(tile_t *tile_out, tile_t *tile_in1, tile_t *tile_in2, t
 {
   int tid = omp_get_thread_num();
 #if defined (USE_CORE_VERIFICATION)    
-  TaskGraph graph = payload.graph;
-  char *output_ptr = (char*)tile_out->output_buff;
-  size_t output_bytes= graph.output_bytes_per_task;
-  std::vector<const char *> input_ptrs;
-  std::vector<size_t> input_bytes;
-  input_ptrs.push_back((char*)tile_in1->output_buff);
-  input_bytes.push_back(graph.output_bytes_per_task);
-  input_ptrs.push_back((char*)tile_in2->output_buff);
-  input_bytes.push_back(graph.output_bytes_per_task);
-  input_ptrs.push_back((char*)tile_in3->output_buff);
-  input_bytes.push_back(graph.output_bytes_per_task);
-  input_ptrs.push_back((char*)tile_in4->output_buff);
-  input_bytes.push_back(graph.output_bytes_per_task);
-  input_ptrs.push_back((char*)tile_in5->output_buff);
-  input_bytes.push_back(graph.output_bytes_per_task);
-  input_ptrs.push_back((char*)tile_in6->output_buff);
-  input_bytes.push_back(graph.output_bytes_per_task);
-  input_ptrs.push_back((char*)tile_in7->output_buff);
-  input_bytes.push_back(graph.output_bytes_per_task);
-
-  graph.execute_point(payload.y, payload.x, output_ptr, output_bytes,
-                      input_ptrs.data(), input_bytes.data(), input_ptrs.size(), extra_local_memory[tid], graph.scratch_bytes_per_task);
+  const TaskGraph &graph = registered_task_graph(payload.graph_id);
+  char *scratch = scratch_pool.acquire(tid);
+  TaskArgs args;
+  args.reset(tile_out->output_buff, graph.task_output_bytes(payload.timestep, payload.point),
+             scratch, graph.scratch_bytes_per_task);
+  add_tile_input(args, graph, tile_in1, payload);
+  add_tile_input(args, graph, tile_in2, payload);
+  add_tile_input(args, graph, tile_in3, payload);
+  add_tile_input(args, graph, tile_in4, payload);
+  add_tile_input(args, graph, tile_in5, payload);
+  add_tile_input(args, graph, tile_in6, payload);
+  add_tile_input(args, graph, tile_in7, payload);
+  execute_point(payload, args);
+  scratch_pool.release(omp_get_thread_num(), scratch);
 #else
   tile_out->dep = tile_in1->dep + tile_in2->dep + tile_in3->dep + tile_in4->dep + tile_in5->dep + tile_in6->dep + tile_in7->dep + 1;
-  printf("Task8 tid %d, x %d, y %d, out %f, in1 %f, in2 %f, in3 %f, in4 %f, in5 %f, in6 %f, in7 %f\n", 
-    tid, payload.x, payload.y, tile_out->dep,tile_in1->dep, tile_in2->dep, tile_in3->dep, tile_in4->dep, tile_in5->dep, tile_in6->dep, tile_in7->dep);
+  printf("Task8 tid %d, x %ld, y %ld, out %f, in1 %f, in2 %f, in3 %f, in4 %f, in5 %f, in6 %f, in7 %f\n", 
+    tid, payload.point, payload.timestep, tile_out->dep,tile_in1->dep, tile_in2->dep, tile_in3->dep, tile_in4->dep, tile_in5->dep, tile_in6->dep, tile_in7->dep);
 #endif
 }
 
@@ -260,34 +262,25 @@ static inline void task9(tile_t *tile_out, tile_t *tile_in1, tile_t *tile_in2, t
 {
   int tid = omp_get_thread_num();
 #if defined (USE_CORE_VERIFICATION)    
-  TaskGraph graph = payload.graph;
-  char *output_ptr = (char*)tile_out->output_buff;
-  size_t output_bytes= graph.output_bytes_per_task;
-  std::vector<const char *> input_ptrs;
-  std::vector<size_t> input_bytes;
-  input_ptrs.push_back((char*)tile_in1->output_buff);
-  input_bytes.push_back(graph.output_bytes_per_task);
-  input_ptrs.push_back((char*)tile_in2->output_buff);
-  input_bytes.push_back(graph.output_bytes_per_task);
-  input_ptrs.push_back((char*)tile_in3->output_buff);
-  input_bytes.push_back(graph.output_bytes_per_task);
-  input_ptrs.push_back((char*)tile_in4->output_buff);
-  input_bytes.push_back(graph.output_bytes_per_task);
-  input_ptrs.push_back((char*)tile_in5->output_buff);
-  input_bytes.push_back(graph.output_bytes_per_task);
-  input_ptrs.push_back((char*)tile_in6->output_buff);
-  input_bytes.push_back(graph.output_bytes_per_task);
-  input_ptrs.push_back((char*)tile_in7->output_buff);
-  input_bytes.push_back(graph.output_bytes_per_task);
-  input_ptrs.push_back((char*)tile_in8->output_buff);
-  input_bytes.push_back(graph.output_bytes_per_task);
-
-  graph.execute_point(payload.y, payload.x, output_ptr, output_bytes,
-                      input_ptrs.data(), input_bytes.data(), input_ptrs.size(), extra_local_memory[tid], graph.scratch_bytes_per_task);
+  const TaskGraph &graph = registered_task_graph(payload.graph_id);
+  char *scratch = scratch_pool.acquire(tid);
+  TaskArgs args;
+  args.reset(tile_out->output_buff, graph.task_output_bytes(payload.timestep, payload.point),
+             scratch, graph.scratch_bytes_per_task);
+  add_tile_input(args, graph, tile_in1, payload);
+  add_tile_input(args, graph, tile_in2, payload);
+  add_tile_input(args, graph, tile_in3, payload);
+  add_tile_input(args, graph, tile_in4, payload);
+  add_tile_input(args, graph, tile_in5, payload);
+  add_tile_input(args, graph, tile_in6, payload);
+  add_tile_input(args, graph, tile_in7, payload);
+  add_tile_input(args, graph, tile_in8, payload);
+  execute_point(payload, args);
+  scratch_pool.release(omp_get_thread_num(), scratch);
 #else
   tile_out->dep = tile_in1->dep + tile_in2->dep + tile_in3->dep + tile_in4->dep + tile_in5->dep + tile_in6->dep + tile_in7->dep + tile_in8->dep + 1;
-  printf("Task9 tid %d, x %d, y %d, out %f, in1 %f, in2 %f, in3 %f, in4 %f, in5 %f, in6 %f, in7 %f, in8 %f\n", 
-    tid, payload.x, payload.y, tile_out->dep,tile_in1->dep, tile_in2->dep, tile_in3->dep, tile_in4->dep, tile_in5->dep, tile_in6->dep, tile_in7->dep, tile_in8->dep);
+  printf("Task9 tid %d, x %ld, y %ld, out %f, in1 %f, in2 %f, in3 %f, in4 %f, in5 %f, in6 %f, in7 %f, in8 %f\n", 
+    tid, payload.point, payload.timestep, tile_out->dep,tile_in1->dep, tile_in2->dep, tile_in3->dep, tile_in4->dep, tile_in5->dep, tile_in6->dep, tile_in7->dep, tile_in8->dep);
 #endif
 }
 
@@ -295,37 +288,69 @@ static inline void task10(tile_t *tile_out, tile_t *tile_in1, tile_t *tile_in2,
 {
   int tid = omp_get_thread_num();
 #if defined (USE_CORE_VERIFICATION)    
-  TaskGraph graph = payload.graph;
-  char *output_ptr = (char*)tile_out->output_buff;
-  size_t output_bytes= graph.output_bytes_per_task;
-  std::vector<const char *> input_ptrs;
-  std::vector<size_t> input_bytes;
-  input_ptrs.push_back((char*)tile_in1->output_buff);
-  input_bytes.push_back(graph.output_bytes_per_task);
-  input_ptrs.push_back((char*)tile_in2->output_buff);
-  input_bytes.push_back(graph.output_bytes_per_task);
-  input_ptrs.push_back((char*)tile_in3->output_buff);
-  input_bytes.push_back(graph.output_bytes_per_task);
-  input_ptrs.push_back((char*)tile_in4->output_buff);
-  input_bytes.push_back(graph.output_bytes_per_task);
-  input_ptrs.push_back((char*)tile_in5->output_buff);
-  input_bytes.push_back(graph.output_bytes_per_task);
-  input_ptrs.push_back((char*)tile_in6->output_buff);
-  input_bytes.push_back(graph.output_bytes_per_task);
-  input_ptrs.push_back((char*)tile_in7->output_buff);
-  input_bytes.push_back(graph.output_bytes_per_task);
-  input_ptrs.push_back((char*)tile_in8->output_buff);
-  input_bytes.push_back(graph.output_bytes_per_task);
-  input_ptrs.push_back((char*)tile_in9->output_buff);
-  input_bytes.push_back(graph.output_bytes_per_task);
-
-  graph.execute_point(payload.y, payload.x, output_ptr, output_bytes,
-                      input_ptrs.data(), input_bytes.data(), input_ptrs.size(), extra_local_memory[tid], graph.scratch_bytes_per_task);
+  const TaskGraph &graph = registered_task_graph(payload.graph_id);
+  char *scratch = scratch_pool.acquire(tid);
+  TaskArgs args;
+  args.reset(tile_out->output_buff, graph.task_output_bytes(payload.timestep, payload.point),
+             scratch, graph.scratch_bytes_per_task);
+  add_tile_input(args, graph, tile_in1, payload);
+  add_tile_input(args, graph, tile_in2, payload);
+  add_tile_input(args, graph, tile_in3, payload);
+  add_tile_input(args, graph, tile_in4, payload);
+  add_tile_input(args, graph, tile_in5, payload);
+  add_tile_input(args, graph, tile_in6, payload);
+  add_tile_input(args, graph, tile_in7, payload);
+  add_tile_input(args, graph, tile_in8, payload);
+  add_tile_input(args, graph, tile_in9, payload);
+  execute_point(payload, args);
+  scratch_pool.release(omp_get_thread_num(), scratch);
 #else
   tile_out->dep = tile_in1->dep + tile_in2->dep + tile_in3->dep + tile_in4->dep + tile_in5->dep + tile_in6->dep + tile_in7->dep + tile_in8->dep + tile_in9->dep + 1;
-  printf("Task10 tid %d, x %d, y %d, out %f, in1 %f, in2 %f, in3 %f, in4 %f, in5 %f, in6 %f, in7 %f, in8 %f, in9 %f\n", 
-    tid, payload.x, payload.y, tile_out->dep,tile_in1->dep, tile_in2->dep, tile_in3->dep, tile_in4->dep, tile_in5->dep, tile_in6->dep, tile_in7->dep, tile_in8->dep, tile_in9->dep);
+  printf("Task10 tid %d, x %ld, y %ld, out %f, in1 %f, in2 %f, in3 %f, in4 %f, in5 %f, in6 %f, in7 %f, in8 %f, in9 %f\n", 
+    tid, payload.point, payload.timestep, tile_out->dep,tile_in1->dep, tile_in2->dep, tile_in3->dep, tile_in4->dep, tile_in5->dep, tile_in6->dep, tile_in7->dep, tile_in8->dep, tile_in9->dep);
+#endif
+}
+
+// Any number of inputs: the task looks its inputs up itself instead of
+// receiving one tile per argument.
+static inline void task_generic(tile_t *tile_out, payload_t payload, size_t graph_id)
+{
+  int tid = omp_get_thread_num();
+  const TaskGraph &graph = registered_task_graph(payload.graph_id);
+  long t = payload.timestep;
+  long x = payload.point;
+  size_t n_inputs = 0;
+  char *buffer = generic_pool.acquire(tid);
+  generic_inputs_t in = generic_inputs(buffer);
+  if (t > 0) {
+    tile_t *mat = matrix[graph_id].data;
+    long M = matrix[graph_id].M;
+    long N = matrix[graph_id].N;
+    long dset = graph.dependence_set_at_timestep(t);
+    long last_offset = graph.offset_at_timestep(t-1);
+    long last_width = graph.width_at_timestep(t-1);
+    size_t num_deps = graph.dependencies(dset, x, in.deps);
+    for (size_t span = 0; span < num_deps; span++) {
+      for (long i = in.deps[span].first; i <= in.deps[span].second; i++) {
+        if (i >= last_offset && i < last_offset + last_width) {
+          in.input_ptr[n_inputs] = mat[((t-1) % M) * N + i].output_buff + graph.output_field_offset(t-1, i, x);
+          in.input_bytes[n_inputs] = graph.output_field_bytes(t-1, i, x);
+          n_inputs++;
+        }
+      }
+    }
+  }
+#if defined (USE_CORE_VERIFICATION)
+  char *scratch = scratch_pool.acquire(tid);
+  graph.execute_point(t, x, tile_out->output_buff, graph.task_output_bytes(t, x),
+                      in.input_ptr, in.input_bytes, n_inputs,
+                      scratch, graph.scratch_bytes_per_task);
+  scratch_pool.release(omp_get_thread_num(), scratch);
+#else
+  tile_out->dep = n_inputs + 1;
+  printf("TaskGeneric tid %d, x %ld, y %ld, out %f, inputs %zu\n", tid, payload.point, payload.timestep, tile_out->dep, n_inputs);
 #endif
+  generic_pool.release(omp_get_thread_num(), buffer);
 }
 
 struct OpenMPApp : public App {
@@ -334,27 +359,99 @@ struct OpenMPApp : public App {
   void execute_main_loop();
   void execute_timestep(size_t idx, long t);
 private:
+  void insert_window_marker(size_t idx, long t);
+  void wait_window_marker(long t);
+  void insert_completion_marker(size_t idx);
+  void create_tasks(unsigned first, unsigned last, bool round_robin);
+  void run_graphs(unsigned first, unsigned last, bool round_robin);
+  void execute_tenants();
   void insert_task(task_args_t *args, int num_args, payload_t payload, size_t graph_id);
+  void insert_task_generic(task_args_t *args, int num_args, payload_t payload, size_t graph_id);
   void debug_printf(int verbose_level, const char *format, ...);
 private:
   int nb_workers;
+  ThreadPinning *pinning;
+  // use task_generic even when a fixed-arity task would do
+  bool generic_deps;
+  // at most this many timesteps of a graph in flight, 0 for no limit
+  int window;
+  // one per window slot; the marker of timestep t completes after every
+  // task of t does
+  char *window_markers;
+  // create the timesteps of all graphs round-robin instead of one
+  // graph after the other
+  bool concurrent;
+  // Timer value at which each graph's last task completed
+  std::vector<double> completed_at;
+  // Graphs of tenant k are [tenant_first_graph[k],
+  // tenant_first_graph[k + 1]); tenant 0 is this App.
+  std::vector<unsigned> tenant_first_graph;
+  bool tenant_priority;
+  // reused by execute_timestep so that no task allocates its dependencies
+  std::vector<std::pair<long, long> > deps_buffer;
+  std::vector<task_args_t> args_buffer;
+  std::vector<long> in_buffer;
+  Arena *output_arenas;
 //  matrix_t *matrix;
 };
 
-matrix_t *matrix = NULL;
-
 OpenMPApp::OpenMPApp(int argc, char **argv)
   : App(argc, argv)
 { 
+  use_min_fields();
   nb_workers = 1;
+  generic_deps = false;
+  window = 0;
+  concurrent = false;
+  tenant_priority = false;
   
   for (int k = 1; k < argc; k++) {
     if (!strcmp(argv[k], "-worker")) {
       nb_workers = atol(argv[++k]);
     }
+    if (!strcmp(argv[k], "-generic-deps")) {
+      generic_deps = true;
+    }
+    if (!strcmp(argv[k], "-concurrent")) {
+      concurrent = true;
+    }
+    if (!strcmp(argv[k], "-tenant-policy") && k + 1 < argc) {
+      const char *name = argv[++k];
+      if (!strcmp(name, "priority")) {
+        tenant_priority = true;
+      } else if (strcmp(name, "fair")) {
+        fprintf(stderr, "error: Invalid flag \"-tenant-policy %s\"\n", name);
+        abort();
+      }
+    }
+    if (!strcmp(argv[k], "-window") && k + 1 < argc) {
+      window = atol(argv[++k]);
+      if (window < 0) {
+        fprintf(stderr, "error: Invalid flag \"-window %d\" must be >= 0\n", window);
+        abort();
+      }
+    }
+  }
+  window_markers = (char *)malloc(window > 0 ? window : 1);
+
+  // Each -tenant adds the graphs of another App; they are set up like
+  // this App's own.
+  tenant_first_graph.push_back(0);
+  for (auto &args : tenant_args(argc, argv)) {
+    App tenant(args.size(), args.data(), graphs.size());
+    tenant.use_min_fields();
+    tenant_first_graph.push_back(graphs.size());
+    graphs.insert(graphs.end(), tenant.graphs.begin(), tenant.graphs.end());
   }
+  tenant_first_graph.push_back(graphs.size());
+  completed_at.resize(graphs.size(), 0.0);
   
+  printf("nb_workers %d\n", nb_workers);
+ // omp_set_dynamic(1);
+  omp_set_num_threads(nb_workers);
+
   matrix = (matrix_t *)malloc(sizeof(matrix_t) * graphs.size());
+  output_arenas = new Arena[graphs.size()];
   
   size_t max_scratch_bytes_per_task = 0;
   
@@ -363,40 +460,83 @@ OpenMPApp::OpenMPApp(int argc, char **argv)
     
     matrix[i].M = graph.nb_fields;
     matrix[i].N = graph.max_width;
-    matrix[i].data = (tile_t*)malloc(sizeof(tile_t) * matrix[i].M * matrix[i].N);
+
+    for (long dset = 0; dset < graph.max_dependence_sets(); dset++) {
+      for (long x = 0; x < graph.max_width; x++) {
+        size_t max_deps = graph.num_dependencies(dset, x);
+        if (max_deps > deps_buffer.size()) {
+          deps_buffer.resize(max_deps);
+        }
+      }
+    }
+    size_t num_tiles = checked_mul(matrix[i].M, matrix[i].N, "tile matrix");
+    matrix[i].data = (tile_t*)malloc(checked_mul(sizeof(tile_t), num_tiles, "tile matrix"));
   
-    for (int j = 0; j < matrix[i].M * matrix[i].N; j++) {
-      matrix[i].data[j].output_buff = (char *)malloc(sizeof(char) * graph.output_bytes_per_task);
+    Arena &arena = output_arenas[i];
+    arena.allocate(num_tiles, graph.max_output_bytes(), placement, huge_pages);
+    for (long j = 0; j < matrix[i].M * matrix[i].N; j++) {
+      matrix[i].data[j].point = j % matrix[i].N;
+      matrix[i].data[j].output_buff = arena.block(j);
+    }
+
+    // Spread columns over the workers the same way a static schedule
+    // would, so that each page of a row lands near the workers that
+    // write it.
+    if (placement == PLACEMENT_FIRST_TOUCH) {
+      long M = matrix[i].M;
+      long N = matrix[i].N;
+      #pragma omp parallel for schedule(static)
+      for (long x = 0; x < N; x++) {
+        for (long y = 0; y < M; y++) {
+          arena.touch(y * N + x, 1);
+        }
+      }
     }
     
     if (graph.scratch_bytes_per_task > max_scratch_bytes_per_task) {
       max_scratch_bytes_per_task = graph.scratch_bytes_per_task;
     }
     
-    printf("graph id %d, M = %d, N = %d, data %p, nb_fields %d\n", i, matrix[i].M, matrix[i].N, matrix[i].data, graph.nb_fields);
+    printf("graph id %d, M = %ld, N = %ld, data %p, nb_fields %d\n", i, matrix[i].M, matrix[i].N, matrix[i].data, graph.nb_fields);
   }
   
-  extra_local_memory = (char**)malloc(sizeof(char*) * nb_workers);
-  assert(extra_local_memory != NULL);
-  for (int k = 0; k < nb_workers; k++) {
-    if (max_scratch_bytes_per_task > 0) {
-      extra_local_memory[k] = (char*)malloc(sizeof(char)*max_scratch_bytes_per_task);
-      TaskGraph::prepare_scratch(extra_local_memory[k], sizeof(char)*max_scratch_bytes_per_task);
-    } else {
-      extra_local_memory[k] = NULL;
+  // Size the argument buffers for the task with the most inputs: one
+  // argument for the output plus one per input.
+  size_t max_inputs = 0;
+  for (unsigned i = 0; i < graphs.size(); i++) {
+    TaskGraph &graph = graphs[i];
+    for (long dset = 0; dset < graph.max_dependence_sets(); dset++) {
+      for (long x = 0; x < graph.max_width; x++) {
+        size_t num_deps = graph.dependencies(dset, x, deps_buffer.data());
+        size_t inputs = 0;
+        for (size_t span = 0; span < num_deps; span++) {
+          inputs += deps_buffer[span].second - deps_buffer[span].first + 1;
+        }
+        max_inputs = std::max(max_inputs, inputs);
+      }
     }
   }
-  printf("nb_workers %d\n", nb_workers);
- // omp_set_dynamic(1);
-  omp_set_num_threads(nb_workers);
-  
-  if (max_scratch_bytes_per_task > 0) {
-    #pragma omp parallel
-    {
-      int tid = omp_get_thread_num();
-      //printf("im tid %d\n", tid);
-      TaskGraph::prepare_scratch(extra_local_memory[tid], sizeof(char)*max_scratch_bytes_per_task);
-    }
+  args_buffer.resize(max_inputs + 1);
+  in_buffer.resize(max_inputs);
+
+  generic_max_deps = deps_buffer.size();
+  generic_max_inputs = max_inputs;
+  generic_pool.allocate(nb_workers,
+                        sizeof(std::pair<long, long>) * generic_max_deps +
+                        (sizeof(const char *) + sizeof(size_t)) * generic_max_inputs,
+                        placement, huge_pages);
+
+  // Each worker touches and initializes the scratch buffers that start
+  // out near it.
+  scratch_pool.allocate(nb_workers, max_scratch_bytes_per_task, placement, huge_pages);
+  // Pin once here, before the first touch; the runtime keeps the
+  // same threads for later teams of the same size.
+  pinning = new ThreadPinning(pin_policy, pin_cpus, nb_workers);
+  #pragma omp parallel
+  {
+    pinning->pin(omp_get_thread_num());
+    scratch_pool.touch(omp_get_thread_num(), TaskGraph::prepare_scratch);
+    generic_pool.touch(omp_get_thread_num());
   }
 
 }
@@ -404,51 +544,175 @@ OpenMPApp::OpenMPApp(int argc, char **argv)
 OpenMPApp::~OpenMPApp()
 {
   for (unsigned i = 0; i < graphs.size(); i++) {
-    for (int j = 0; j < matrix[i].M * matrix[i].N; j++) {
-      free(matrix[i].data[j].output_buff);
-      matrix[i].data[j].output_buff = NULL;
-    }
     free(matrix[i].data);
     matrix[i].data = NULL;
   }
   
   free(matrix);
   matrix = NULL;
+
+  delete pinning;
+  pinning = NULL;
+
+  delete [] output_arenas;
+  output_arenas = NULL;
   
-  for (int j = 0; j < nb_workers; j++) {
-    if (extra_local_memory[j] != NULL) {
-      free(extra_local_memory[j]);
-      extra_local_memory[j] = NULL;
-    }
-  }
-  free(extra_local_memory);
-  extra_local_memory = NULL;
+  free(window_markers);
+  window_markers = NULL;
 }
 
 void OpenMPApp::execute_main_loop()
 { 
+  if (tenant_first_graph.size() > 2) {
+    execute_tenants();
+    return;
+  }
+
   display();
+  pinning->display();
+  if (window > 0) {
+    printf("Window: %d timesteps\n", window);
+  } else {
+    printf("Window: unbounded\n");
+  }
+  printf("Graphs: %s\n", concurrent ? "concurrent, round-robin timesteps" : "one after another");
   
-  Timer::time_start();
+  struct rusage usage;
+  getrusage(RUSAGE_SELF, &usage);
+  long rss_before = usage.ru_maxrss;
   
+  double start = Timer::time_start();
+  run_graphs(0, graphs.size(), concurrent);
+  double elapsed = Timer::time_end();
+  getrusage(RUSAGE_SELF, &usage);
+  printf("Peak memory growth: %ld KiB\n", usage.ru_maxrss - rss_before);
+  report_timing(elapsed);
+  for (unsigned i = 0; i < graphs.size(); i++) {
+    printf("Graph %u completed: %e seconds\n", i, completed_at[i] - start);
+  }
+}
+
+void OpenMPApp::execute_tenants()
+{
+  unsigned num_tenants = tenant_first_graph.size() - 1;
+  display();
+  pinning->display();
+  for (unsigned k = 0; k < num_tenants; k++) {
+    printf("Tenant %u: graphs %u to %u\n", k, tenant_first_graph[k], tenant_first_graph[k + 1] - 1);
+  }
+  printf("Tenant policy: %s\n", tenant_priority ? "priority" : "fair share");
+  if (tenant_priority && omp_get_max_task_priority() < (int)num_tenants - 1) {
+    printf("warning: OMP_MAX_TASK_PRIORITY is %d, so priorities are capped below the %u tenants\n",
+           omp_get_max_task_priority(), num_tenants);
+  }
+
+  // Baseline: each tenant with all threads to itself.
+  std::vector<double> alone;
+  for (unsigned k = 0; k < num_tenants; k++) {
+    double start = Timer::get_cur_time();
+    run_graphs(tenant_first_graph[k], tenant_first_graph[k + 1], true);
+    alone.push_back(Timer::get_cur_time() - start);
+  }
+
+  double start = Timer::time_start();
+  run_graphs(0, graphs.size(), true);
+  double elapsed = Timer::time_end();
+  report_timing(elapsed);
+
+  for (unsigned k = 0; k < num_tenants; k++) {
+    double shared = 0.0;
+    long tasks = 0;
+    for (unsigned i = tenant_first_graph[k]; i < tenant_first_graph[k + 1]; i++) {
+      shared = std::max(shared, completed_at[i] - start);
+      for (long t = 0; t < graphs[i].timesteps; t++) {
+        tasks += graphs[i].width_at_timestep(t);
+      }
+    }
+    printf("Tenant %u: alone %e s, shared %e s, slowdown %.2fx, %e tasks/s shared\n",
+           k, alone[k], shared, shared / alone[k], tasks / shared);
+  }
+}
+
+void OpenMPApp::run_graphs(unsigned first, unsigned last, bool round_robin)
+{
   #pragma omp parallel
   {
     #pragma omp master
     {
-      for (unsigned i = 0; i < graphs.size(); i++) {
+      create_tasks(first, last, round_robin);
+    }
+    #pragma omp barrier
+  }
+}
+
+// Creates the tasks of graphs [first, last): graph after graph, or with
+// round_robin one timestep of every graph at a time.
+void OpenMPApp::create_tasks(unsigned first, unsigned last, bool round_robin)
+{
+  unsigned num_tenants = tenant_first_graph.size() - 1;
+  long max_timesteps = 0;
+  for (unsigned i = first; i < last; i++) {
+    max_timesteps = std::max(max_timesteps, graphs[i].timesteps);
+  }
+  unsigned passes = round_robin ? 1 : last - first;
+  for (unsigned pass = 0; pass < passes; pass++) {
+    unsigned pass_first = round_robin ? first : first + pass;
+    unsigned pass_last = round_robin ? last : first + pass + 1;
+    long timesteps = round_robin ? max_timesteps : graphs[pass_first].timesteps;
+    for (long y = 0; y < timesteps; y++) {
+      // Keeps the runtime's task and dependency tables at W
+      // timesteps instead of the whole graph. The master runs
+      // tasks while it waits.
+      if (window > 0 && y >= window) {
+        wait_window_marker(y - window);
+      }
+      unsigned tenant = 0;
+      for (unsigned i = pass_first; i < pass_last; i++) {
         const TaskGraph &g = graphs[i];
-        for (int y = 0; y < g.timesteps; y++) {
-          execute_timestep(i, y);
+        while (i >= tenant_first_graph[tenant + 1]) tenant++;
+        if (y >= g.timesteps) continue;
+        task_priority = tenant_priority ? num_tenants - 1 - tenant : 0;
+        execute_timestep(i, y);
+        if (window > 0) {
+          insert_window_marker(i, y);
+        }
+        if (y == g.timesteps - 1) {
+          insert_completion_marker(i);
         }
-        
       }
-//      #pragma omp taskwait
     }
-    #pragma omp barrier
   }
-  
-  double elapsed = Timer::time_end();
-  report_timing(elapsed);
+}
+
+void OpenMPApp::insert_completion_marker(size_t idx)
+{
+  // Every task writes a tile with inout, so the last writers of all
+  // tiles of a graph finish after all of its tasks.
+  long num_tiles = matrix[idx].M * matrix[idx].N;
+  double *completed = &completed_at[idx];
+  #pragma omp task depend(iterator(long i = 0:num_tiles), in: matrix[idx].data[i]) untied
+  {
+    *completed = Timer::get_cur_time();
+  }
+}
+
+void OpenMPApp::insert_window_marker(size_t idx, long t)
+{
+  const TaskGraph &g = graphs[idx];
+  long first = (t % g.nb_fields) * matrix[idx].N + g.offset_at_timestep(t);
+  long width = g.width_at_timestep(t);
+  long slot = t % window;
+  // Created right after the tasks of t, so the last writers of these
+  // tiles are exactly those tasks.
+  #pragma omp task depend(iterator(long i = 0:width), in: matrix[idx].data[first + i]) depend(out: window_markers[slot]) untied mergeable
+  {
+  }
+}
+
+void OpenMPApp::wait_window_marker(long t)
+{
+  long slot = t % window;
+  #pragma omp taskwait depend(in: window_markers[slot])
 }
 
 void OpenMPApp::execute_timestep(size_t idx, long t)
@@ -459,26 +723,27 @@ void OpenMPApp::execute_timestep(size_t idx, long t)
   long dset = g.dependence_set_at_timestep(t);
   int nb_fields = g.nb_fields;
   
-  task_args_t args[MAX_NUM_ARGS];
+  task_args_t *args = args_buffer.data();
   payload_t payload;
   int num_args = 0;
   int ct = 0;  
   
-  for (int x = offset; x <= offset+width-1; x++) {
-    std::vector<std::pair<long, long> > deps = g.dependencies(dset, x);   
+  for (long x = offset; x <= offset+width-1; x++) {
+    std::pair<long, long> *deps = deps_buffer.data();
+    size_t num_deps = g.dependencies(dset, x, deps);
     num_args = 0;
     ct = 0;    
     
-    if (deps.size() == 0) {
+    if (num_deps == 0) {
       num_args = 1;
-      debug_printf(1, "%d[%d] ", x, num_args);
+      debug_printf(1, "%ld[%d] ", x, num_args);
       args[ct].x = x;
       args[ct].y = t % nb_fields;
       ct ++;
     } else {
       if (t == 0) {
         num_args = 1;
-        debug_printf(1, "%d[%d] ", x, num_args);
+        debug_printf(1, "%ld[%d] ", x, num_args);
         args[ct].x = x;
         args[ct].y = t % nb_fields;
         ct ++;
@@ -489,10 +754,11 @@ void OpenMPApp::execute_timestep(size_t idx, long t)
         ct ++;
         long last_offset = g.offset_at_timestep(t-1);
         long last_width = g.width_at_timestep(t-1);
-        for (std::pair<long, long> dep : deps) {
+        for (size_t span = 0; span < num_deps; span++) {
+          std::pair<long, long> dep = deps[span];
           num_args += dep.second - dep.first + 1;
-          debug_printf(1, "%d[%d, %d, %d] ", x, num_args, dep.first, dep.second); 
-          for (int i = dep.first; i <= dep.second; i++) {
+          debug_printf(1, "%ld[%d, %ld, %ld] ", x, num_args, dep.first, dep.second); 
+          for (long i = dep.first; i <= dep.second; i++) {
             if (i >= last_offset && i < last_offset + last_width) {
               args[ct].x = i;
               args[ct].y = (t-1) % nb_fields;
@@ -507,32 +773,37 @@ void OpenMPApp::execute_timestep(size_t idx, long t)
     
     assert(num_args == ct);
     
-    payload.y = t;
-    payload.x = x;
-    payload.graph = g;
+    payload.timestep = t;
+    payload.point = x;
+    payload.graph_id = g.graph_index;
     insert_task(args, num_args, payload, idx);
   }
 }
 
 void OpenMPApp::insert_task(task_args_t *args, int num_args, payload_t payload, size_t graph_id)
 {
+  if (generic_deps || num_args > MAX_NUM_ARGS) {
+    insert_task_generic(args, num_args, payload, graph_id);
+    return;
+  }
+
   tile_t *mat = matrix[graph_id].data;
-  int x0 = args[0].x;
-  int y0 = args[0].y;
-//  printf("x %d, y %d, mat %p\n", x0, y0, mat);
+  long x0 = args[0].x;
+  long y0 = args[0].y;
+//  printf("x %ld, y %ld, mat %p\n", x0, y0, mat);
   switch(num_args) {
   case 1:
   {
-    #pragma omp task depend(inout: mat[y0 * matrix[graph_id].N + x0]) untied mergeable
+    #pragma omp task depend(inout: mat[y0 * matrix[graph_id].N + x0]) priority(task_priority) untied mergeable
       task1(&mat[y0 * matrix[graph_id].N + x0], payload);
     break;
   }
   
   case 2: 
   {
-    int x1 = args[1].x;
-    int y1 = args[1].y;
-    #pragma omp task depend(in: mat[y1 * matrix[graph_id].N + x1]) depend(inout: mat[y0 * matrix[graph_id].N + x0]) untied mergeable
+    long x1 = args[1].x;
+    long y1 = args[1].y;
+    #pragma omp task depend(in: mat[y1 * matrix[graph_id].N + x1]) depend(inout: mat[y0 * matrix[graph_id].N + x0]) priority(task_priority) untied mergeable
       task2(&mat[y0 * matrix[graph_id].N + x0], 
             &mat[y1 * matrix[graph_id].N + x1], payload);
     break;
@@ -540,11 +811,11 @@ void OpenMPApp::insert_task(task_args_t *args, int num_args, payload_t payload,
   
   case 3: 
   {
-    int x1 = args[1].x;
-    int y1 = args[1].y;
-    int x2 = args[2].x;
-    int y2 = args[2].y;
-    #pragma omp task depend(in: mat[y1 * matrix[graph_id].N + x1]) depend(in: mat[y2 * matrix[graph_id].N + x2]) depend(inout: mat[y0 * matrix[graph_id].N + x0]) untied mergeable
+    long x1 = args[1].x;
+    long y1 = args[1].y;
+    long x2 = args[2].x;
+    long y2 = args[2].y;
+    #pragma omp task depend(in: mat[y1 * matrix[graph_id].N + x1]) depend(in: mat[y2 * matrix[graph_id].N + x2]) depend(inout: mat[y0 * matrix[graph_id].N + x0]) priority(task_priority) untied mergeable
       task3(&mat[y0 * matrix[graph_id].N + x0], 
             &mat[y1 * matrix[graph_id].N + x1], 
             &mat[y2 * matrix[graph_id].N + x2], payload);
@@ -553,13 +824,13 @@ void OpenMPApp::insert_task(task_args_t *args, int num_args, payload_t payload,
   
   case 4: 
   {
-    int x1 = args[1].x;
-    int y1 = args[1].y;
-    int x2 = args[2].x;
-    int y2 = args[2].y;
-    int x3 = args[3].x;
-    int y3 = args[3].y;
-    #pragma omp task depend(in: mat[y1 * matrix[graph_id].N + x1]) depend(in: mat[y2 * matrix[graph_id].N + x2]) depend(in: mat[y3 * matrix[graph_id].N + x3]) depend(inout: mat[y0 * matrix[graph_id].N + x0]) untied mergeable
+    long x1 = args[1].x;
+    long y1 = args[1].y;
+    long x2 = args[2].x;
+    long y2 = args[2].y;
+    long x3 = args[3].x;
+    long y3 = args[3].y;
+    #pragma omp task depend(in: mat[y1 * matrix[graph_id].N + x1]) depend(in: mat[y2 * matrix[graph_id].N + x2]) depend(in: mat[y3 * matrix[graph_id].N + x3]) depend(inout: mat[y0 * matrix[graph_id].N + x0]) priority(task_priority) untied mergeable
       task4(&mat[y0 * matrix[graph_id].N + x0], 
             &mat[y1 * matrix[graph_id].N + x1], 
             &mat[y2 * matrix[graph_id].N + x2], 
@@ -569,15 +840,15 @@ void OpenMPApp::insert_task(task_args_t *args, int num_args, payload_t payload,
   
   case 5: 
   {
-    int x1 = args[1].x;
-    int y1 = args[1].y;
-    int x2 = args[2].x;
-    int y2 = args[2].y;
-    int x3 = args[3].x;
-    int y3 = args[3].y;
-    int x4 = args[4].x;
-    int y4 = args[4].y;
-    #pragma omp task depend(in: mat[y1 * matrix[graph_id].N + x1]) depend(in: mat[y2 * matrix[graph_id].N + x2]) depend(in: mat[y3 * matrix[graph_id].N + x3]) depend(in: mat[y4 * matrix[graph_id].N + x4]) depend(inout: mat[y0 * matrix[graph_id].N + x0]) untied mergeable
+    long x1 = args[1].x;
+    long y1 = args[1].y;
+    long x2 = args[2].x;
+    long y2 = args[2].y;
+    long x3 = args[3].x;
+    long y3 = args[3].y;
+    long x4 = args[4].x;
+    long y4 = args[4].y;
+    #pragma omp task depend(in: mat[y1 * matrix[graph_id].N + x1]) depend(in: mat[y2 * matrix[graph_id].N + x2]) depend(in: mat[y3 * matrix[graph_id].N + x3]) depend(in: mat[y4 * matrix[graph_id].N + x4]) depend(inout: mat[y0 * matrix[graph_id].N + x0]) priority(task_priority) untied mergeable
       task5(&mat[y0 * matrix[graph_id].N + x0], 
             &mat[y1 * matrix[graph_id].N + x1], 
             &mat[y2 * matrix[graph_id].N + x2], 
@@ -588,17 +859,17 @@ void OpenMPApp::insert_task(task_args_t *args, int num_args, payload_t payload,
   
   case 6: 
   {
-    int x1 = args[1].x;
-    int y1 = args[1].y;
-    int x2 = args[2].x;
-    int y2 = args[2].y;
-    int x3 = args[3].x;
-    int y3 = args[3].y;
-    int x4 = args[4].x;
-    int y4 = args[4].y;
-    int x5 = args[5].x;
-    int y5 = args[5].y;
-    #pragma omp task depend(in: mat[y1 * matrix[graph_id].N + x1]) depend(in: mat[y2 * matrix[graph_id].N + x2]) depend(in: mat[y3 * matrix[graph_id].N + x3]) depend(in: mat[y4 * matrix[graph_id].N + x4]) depend(in: mat[y5 * matrix[graph_id].N + x5]) depend(inout: mat[y0 * matrix[graph_id].N + x0]) untied mergeable
+    long x1 = args[1].x;
+    long y1 = args[1].y;
+    long x2 = args[2].x;
+    long y2 = args[2].y;
+    long x3 = args[3].x;
+    long y3 = args[3].y;
+    long x4 = args[4].x;
+    long y4 = args[4].y;
+    long x5 = args[5].x;
+    long y5 = args[5].y;
+    #pragma omp task depend(in: mat[y1 * matrix[graph_id].N + x1]) depend(in: mat[y2 * matrix[graph_id].N + x2]) depend(in: mat[y3 * matrix[graph_id].N + x3]) depend(in: mat[y4 * matrix[graph_id].N + x4]) depend(in: mat[y5 * matrix[graph_id].N + x5]) depend(inout: mat[y0 * matrix[graph_id].N + x0]) priority(task_priority) untied mergeable
       task6(&mat[y0 * matrix[graph_id].N + x0], 
             &mat[y1 * matrix[graph_id].N + x1], 
             &mat[y2 * matrix[graph_id].N + x2], 
@@ -610,19 +881,19 @@ void OpenMPApp::insert_task(task_args_t *args, int num_args, payload_t payload,
   
   case 7: 
   {
-    int x1 = args[1].x;
-    int y1 = args[1].y;
-    int x2 = args[2].x;
-    int y2 = args[2].y;
-    int x3 = args[3].x;
-    int y3 = args[3].y;
-    int x4 = args[4].x;
-    int y4 = args[4].y;
-    int x5 = args[5].x;
-    int y5 = args[5].y;
-    int x6 = args[6].x;
-    int y6 = args[6].y;
-    #pragma omp task depend(in: mat[y1 * matrix[graph_id].N + x1]) depend(in: mat[y2 * matrix[graph_id].N + x2]) depend(in: mat[y3 * matrix[graph_id].N + x3]) depend(in: mat[y4 * matrix[graph_id].N + x4]) depend(in: mat[y5 * matrix[graph_id].N + x5]) depend(in: mat[y6 * matrix[graph_id].N + x6]) depend(inout: mat[y0 * matrix[graph_id].N + x0]) untied mergeable
+    long x1 = args[1].x;
+    long y1 = args[1].y;
+    long x2 = args[2].x;
+    long y2 = args[2].y;
+    long x3 = args[3].x;
+    long y3 = args[3].y;
+    long x4 = args[4].x;
+    long y4 = args[4].y;
+    long x5 = args[5].x;
+    long y5 = args[5].y;
+    long x6 = args[6].x;
+    long y6 = args[6].y;
+    #pragma omp task depend(in: mat[y1 * matrix[graph_id].N + x1]) depend(in: mat[y2 * matrix[graph_id].N + x2]) depend(in: mat[y3 * matrix[graph_id].N + x3]) depend(in: mat[y4 * matrix[graph_id].N + x4]) depend(in: mat[y5 * matrix[graph_id].N + x5]) depend(in: mat[y6 * matrix[graph_id].N + x6]) depend(inout: mat[y0 * matrix[graph_id].N + x0]) priority(task_priority) untied mergeable
       task7(&mat[y0 * matrix[graph_id].N + x0], 
             &mat[y1 * matrix[graph_id].N + x1], 
             &mat[y2 * matrix[graph_id].N + x2], 
@@ -635,21 +906,21 @@ void OpenMPApp::insert_task(task_args_t *args, int num_args, payload_t payload,
   
   case 8: 
   {
-    int x1 = args[1].x;
-    int y1 = args[1].y;
-    int x2 = args[2].x;
-    int y2 = args[2].y;
-    int x3 = args[3].x;
-    int y3 = args[3].y;
-    int x4 = args[4].x;
-    int y4 = args[4].y;
-    int x5 = args[5].x;
-    int y5 = args[5].y;
-    int x6 = args[6].x;
-    int y6 = args[6].y;
-    int x7 = args[7].x;
-    int y7 = args[7].y;
-    #pragma omp task depend(in: mat[y1 * matrix[graph_id].N + x1]) depend(in: mat[y2 * matrix[graph_id].N + x2]) depend(in: mat[y3 * matrix[graph_id].N + x3]) depend(in: mat[y4 * matrix[graph_id].N + x4]) depend(in: mat[y5 * matrix[graph_id].N + x5]) depend(in: mat[y6 * matrix[graph_id].N + x6]) depend(in: mat[y7 * matrix[graph_id].N + x7]) depend(inout: mat[y0 * matrix[graph_id].N + x0]) untied mergeable
+    long x1 = args[1].x;
+    long y1 = args[1].y;
+    long x2 = args[2].x;
+    long y2 = args[2].y;
+    long x3 = args[3].x;
+    long y3 = args[3].y;
+    long x4 = args[4].x;
+    long y4 = args[4].y;
+    long x5 = args[5].x;
+    long y5 = args[5].y;
+    long x6 = args[6].x;
+    long y6 = args[6].y;
+    long x7 = args[7].x;
+    long y7 = args[7].y;
+    #pragma omp task depend(in: mat[y1 * matrix[graph_id].N + x1]) depend(in: mat[y2 * matrix[graph_id].N + x2]) depend(in: mat[y3 * matrix[graph_id].N + x3]) depend(in: mat[y4 * matrix[graph_id].N + x4]) depend(in: mat[y5 * matrix[graph_id].N + x5]) depend(in: mat[y6 * matrix[graph_id].N + x6]) depend(in: mat[y7 * matrix[graph_id].N + x7]) depend(inout: mat[y0 * matrix[graph_id].N + x0]) priority(task_priority) untied mergeable
       task8(&mat[y0 * matrix[graph_id].N + x0], 
             &mat[y1 * matrix[graph_id].N + x1], 
             &mat[y2 * matrix[graph_id].N + x2], 
@@ -663,23 +934,23 @@ void OpenMPApp::insert_task(task_args_t *args, int num_args, payload_t payload,
   
   case 9: 
   {
-    int x1 = args[1].x;
-    int y1 = args[1].y;
-    int x2 = args[2].x;
-    int y2 = args[2].y;
-    int x3 = args[3].x;
-    int y3 = args[3].y;
-    int x4 = args[4].x;
-    int y4 = args[4].y;
-    int x5 = args[5].x;
-    int y5 = args[5].y;
-    int x6 = args[6].x;
-    int y6 = args[6].y;
-    int x7 = args[7].x;
-    int y7 = args[7].y;
-    int x8 = args[8].x;
-    int y8 = args[8].y;
-    #pragma omp task depend(in: mat[y1 * matrix[graph_id].N + x1]) depend(in: mat[y2 * matrix[graph_id].N + x2]) depend(in: mat[y3 * matrix[graph_id].N + x3]) depend(in: mat[y4 * matrix[graph_id].N + x4]) depend(in: mat[y5 * matrix[graph_id].N + x5]) depend(in: mat[y6 * matrix[graph_id].N + x6]) depend(in: mat[y7 * matrix[graph_id].N + x7]) depend(in: mat[y8 * matrix[graph_id].N + x8]) depend(inout: mat[y0 * matrix[graph_id].N + x0]) untied mergeable
+    long x1 = args[1].x;
+    long y1 = args[1].y;
+    long x2 = args[2].x;
+    long y2 = args[2].y;
+    long x3 = args[3].x;
+    long y3 = args[3].y;
+    long x4 = args[4].x;
+    long y4 = args[4].y;
+    long x5 = args[5].x;
+    long y5 = args[5].y;
+    long x6 = args[6].x;
+    long y6 = args[6].y;
+    long x7 = args[7].x;
+    long y7 = args[7].y;
+    long x8 = args[8].x;
+    long y8 = args[8].y;
+    #pragma omp task depend(in: mat[y1 * matrix[graph_id].N + x1]) depend(in: mat[y2 * matrix[graph_id].N + x2]) depend(in: mat[y3 * matrix[graph_id].N + x3]) depend(in: mat[y4 * matrix[graph_id].N + x4]) depend(in: mat[y5 * matrix[graph_id].N + x5]) depend(in: mat[y6 * matrix[graph_id].N + x6]) depend(in: mat[y7 * matrix[graph_id].N + x7]) depend(in: mat[y8 * matrix[graph_id].N + x8]) depend(inout: mat[y0 * matrix[graph_id].N + x0]) priority(task_priority) untied mergeable
       task9(&mat[y0 * matrix[graph_id].N + x0], 
             &mat[y1 * matrix[graph_id].N + x1], 
             &mat[y2 * matrix[graph_id].N + x2], 
@@ -694,25 +965,25 @@ void OpenMPApp::insert_task(task_args_t *args, int num_args, payload_t payload,
   
   case 10: 
   {
-    int x1 = args[1].x;
-    int y1 = args[1].y;
-    int x2 = args[2].x;
-    int y2 = args[2].y;
-    int x3 = args[3].x;
-    int y3 = args[3].y;
-    int x4 = args[4].x;
-    int y4 = args[4].y;
-    int x5 = args[5].x;
-    int y5 = args[5].y;
-    int x6 = args[6].x;
-    int y6 = args[6].y;
-    int x7 = args[7].x;
-    int y7 = args[7].y;
-    int x8 = args[8].x;
-    int y8 = args[8].y;
-    int x9 = args[9].x;
-    int y9 = args[9].y;
-    #pragma omp task depend(in: mat[y1 * matrix[graph_id].N + x1]) depend(in: mat[y2 * matrix[graph_id].N + x2]) depend(in: mat[y3 * matrix[graph_id].N + x3]) depend(in: mat[y4 * matrix[graph_id].N + x4]) depend(in: mat[y5 * matrix[graph_id].N + x5]) depend(in: mat[y6 * matrix[graph_id].N + x6]) depend(in: mat[y7 * matrix[graph_id].N + x7]) depend(in: mat[y8 * matrix[graph_id].N + x8]) depend(in: mat[y9 * matrix[graph_id].N + x9]) depend(inout: mat[y0 * matrix[graph_id].N + x0]) untied mergeable
+    long x1 = args[1].x;
+    long y1 = args[1].y;
+    long x2 = args[2].x;
+    long y2 = args[2].y;
+    long x3 = args[3].x;
+    long y3 = args[3].y;
+    long x4 = args[4].x;
+    long y4 = args[4].y;
+    long x5 = args[5].x;
+    long y5 = args[5].y;
+    long x6 = args[6].x;
+    long y6 = args[6].y;
+    long x7 = args[7].x;
+    long y7 = args[7].y;
+    long x8 = args[8].x;
+    long y8 = args[8].y;
+    long x9 = args[9].x;
+    long y9 = args[9].y;
+    #pragma omp task depend(in: mat[y1 * matrix[graph_id].N + x1]) depend(in: mat[y2 * matrix[graph_id].N + x2]) depend(in: mat[y3 * matrix[graph_id].N + x3]) depend(in: mat[y4 * matrix[graph_id].N + x4]) depend(in: mat[y5 * matrix[graph_id].N + x5]) depend(in: mat[y6 * matrix[graph_id].N + x6]) depend(in: mat[y7 * matrix[graph_id].N + x7]) depend(in: mat[y8 * matrix[graph_id].N + x8]) depend(in: mat[y9 * matrix[graph_id].N + x9]) depend(inout: mat[y0 * matrix[graph_id].N + x0]) priority(task_priority) untied mergeable
       task10(&mat[y0 * matrix[graph_id].N + x0], 
             &mat[y1 * matrix[graph_id].N + x1], 
             &mat[y2 * matrix[graph_id].N + x2], 
@@ -731,6 +1002,22 @@ void OpenMPApp::insert_task(task_args_t *args, int num_args, payload_t payload,
   };
 }
 
+void OpenMPApp::insert_task_generic(task_args_t *args, int num_args, payload_t payload, size_t graph_id)
+{
+  tile_t *mat = matrix[graph_id].data;
+  long N = matrix[graph_id].N;
+  long out = args[0].y * N + args[0].x;
+  int num_in = num_args - 1;
+  long *in = in_buffer.data();
+  for (int i = 0; i < num_in; i++) {
+    in[i] = args[i + 1].y * N + args[i + 1].x;
+  }
+  // The iterator is expanded when the task is created, so in may be
+  // reused right after.
+  #pragma omp task depend(iterator(int i = 0:num_in), in: mat[in[i]]) depend(inout: mat[out]) priority(task_priority) untied mergeable
+    task_generic(&mat[out], payload, graph_id);
+}
+
 void OpenMPApp::debug_printf(int verbose_level, const char *format, ...)
 {
   if (verbose_level > VERBOSE_LEVEL) {
@@ -24,52 +24,62 @@
 
 #define VERBOSE_LEVEL 0
 
+#define CACHE_LINE_SIZE 64
+
 #define USE_CORE_VERIFICATION
 
 #define MAX_NUM_ARGS 10
 
 typedef struct tile_s {
   float dep;
+  long point;
   char *output_buff;
 }tile_t;
 
-typedef struct payload_s {
-  int graph_id;
-  int x;
-  int y;
-  TaskGraph graph;
-}payload_t;
+typedef TaskDescriptor payload_t;
 
 typedef struct task_args_s {
-  int x;
-  int y;
+  long x;
+  long y;
 }task_args_t;
 
 typedef struct matrix_s {
   tile_t *data;
-  int M;
-  int N;
+  char *buffer;
+  long M;
+  long N;
 }matrix_t;
 
-char** extra_local_memory[10];
+// Tasks are untied and may move between threads, so each task takes
+// its own scratch buffer. This needs O(threads) buffers rather than one
+// per point.
+ScratchPool scratch_pool;
+
+// Passes the part of the producer's output that belongs to this
+// consumer. Only edge distributions split an output between consumers.
+static inline void add_tile_input(TaskArgs &args, const TaskGraph &graph,
+                                  const tile_t *tile_in, payload_t payload)
+{
+  long t = payload.timestep - 1;
+  args.add_input(tile_in->output_buff + graph.output_field_offset(t, tile_in->point, payload.point),
+                 graph.output_field_bytes(t, tile_in->point, payload.point));
+}
 
 static inline void task1(tile_t *tile_out, payload_t payload)
 {
   int tid = omp_get_thread_num();
 #if defined (USE_CORE_VERIFICATION)    
-  TaskGraph graph = payload.graph;
-  char *output_ptr = (char*)tile_out->output_buff;
-  size_t output_bytes= graph.output_bytes_per_task;
-  std::vector<const char *> input_ptrs;
-  std::vector<size_t> input_bytes;
-  input_ptrs.push_back((char*)tile_out->output_buff);
-  input_bytes.push_back(graph.output_bytes_per_task);
-  
-  graph.execute_point(payload.y, payload.x, output_ptr, output_bytes,
-                      input_ptrs.data(), input_bytes.data(), input_ptrs.size(), extra_local_memory[payload.graph_id][payload.x], graph.scratch_bytes_per_task);
+  const TaskGraph &graph = registered_task_graph(payload.graph_id);
+  char *scratch = scratch_pool.acquire(tid);
+  TaskArgs args;
+  args.reset(tile_out->output_buff, graph.task_output_bytes(payload.timestep, payload.point),
+             scratch, graph.scratch_bytes_per_task);
+  args.add_input(tile_out->output_buff, args.output_bytes);
+  execute_point(payload, args);
+  scratch_pool.release(omp_get_thread_num(), scratch);
 #else  
   tile_out->dep = 0;
-  printf("Task1 tid %d, x %d, y %d, out %f\n", tid, payload.x, payload.y, tile_out->dep);
+  printf("Task1 tid %d, x %ld, y %ld, out %f\n", tid, payload.point, payload.timestep, tile_out->dep);
 #endif  
 }
 
@@ -77,19 +87,17 @@ static inline void task2(tile_t *tile_out, tile_t *tile_in1, payload_t payload)
 {
   int tid = omp_get_thread_num();
 #if defined (USE_CORE_VERIFICATION)    
-  TaskGraph graph = payload.graph;
-  char *output_ptr = (char*)tile_out->output_buff;
-  size_t output_bytes= graph.output_bytes_per_task;
-  std::vector<const char *> input_ptrs;
-  std::vector<size_t> input_bytes;
-  input_ptrs.push_back((char*)tile_in1->output_buff);
-  input_bytes.push_back(graph.output_bytes_per_task);
-  
-  graph.execute_point(payload.y, payload.x, output_ptr, output_bytes,
-                      input_ptrs.data(), input_bytes.data(), input_ptrs.size(), extra_local_memory[payload.graph_id][payload.x], graph.scratch_bytes_per_task);
+  const TaskGraph &graph = registered_task_graph(payload.graph_id);
+  char *scratch = scratch_pool.acquire(tid);
+  TaskArgs args;
+  args.reset(tile_out->output_buff, graph.task_output_bytes(payload.timestep, payload.point),
+             scratch, graph.scratch_bytes_per_task);
+  add_tile_input(args, graph, tile_in1, payload);
+  execute_point(payload, args);
+  scratch_pool.release(omp_get_thread_num(), scratch);
 #else  
   tile_out->dep = tile_in1->dep + 1;
-  printf("Task2 tid %d, x %d, y %d, out %f, in1 %f\n", tid, payload.x, payload.y, tile_out->dep,tile_in1->dep);
+  printf("Task2 tid %d, x %ld, y %ld, out %f, in1 %f\n", tid, payload.point, payload.timestep, tile_out->dep,tile_in1->dep);
 #endif
 }
 
@@ -97,21 +105,18 @@ static inline void task3(tile_t *tile_out, tile_t *tile_in1, tile_t *tile_in2, p
 {
   int tid = omp_get_thread_num();
 #if defined (USE_CORE_VERIFICATION)    
-  TaskGraph graph = payload.graph;
-  char *output_ptr = (char*)tile_out->output_buff;
-  size_t output_bytes= graph.output_bytes_per_task;
-  std::vector<const char *> input_ptrs;
-  std::vector<size_t> input_bytes;
-  input_ptrs.push_back((char*)tile_in1->output_buff);
-  input_bytes.push_back(graph.output_bytes_per_task);
-  input_ptrs.push_back((char*)tile_in2->output_buff);
-  input_bytes.push_back(graph.output_bytes_per_task);
-
-  graph.execute_point(payload.y, payload.x, output_ptr, output_bytes,
-                     input_ptrs.data(), input_bytes.data(), input_ptrs.size(), extra_local_memory[payload.graph_id][payload.x], graph.scratch_bytes_per_task);
+  const TaskGraph &graph = registered_task_graph(payload.graph_id);
+  char *scratch = scratch_pool.acquire(tid);
+  TaskArgs args;
+  args.reset(tile_out->output_buff, graph.task_output_bytes(payload.timestep, payload.point),
+             scratch, graph.scratch_bytes_per_task);
+  add_tile_input(args, graph, tile_in1, payload);
+  add_tile_input(args, graph, tile_in2, payload);
+  execute_point(payload, args);
+  scratch_pool.release(omp_get_thread_num(), scratch);
 #else  
   tile_out->dep = tile_in1->dep + tile_in2->dep + 1;
-  printf("Task3 tid %d, x %d, y %d, out %f, in1 %f, in2 %f\n", tid, payload.x, payload.y, tile_out->dep,tile_in1->dep, tile_in2->dep);
+  printf("Task3 tid %d, x %ld, y %ld, out %f, in1 %f, in2 %f\n", tid, payload.point, payload.timestep, tile_out->dep,tile_in1->dep, tile_in2->dep);
 #endif
 }
 
@@ -119,23 +124,19 @@ static inline void task4(tile_t *tile_out, tile_t *tile_in1, tile_t *tile_in2, t
 {
   int tid = omp_get_thread_num();
 #if defined (USE_CORE_VERIFICATION)    
-  TaskGraph graph = payload.graph;
-  char *output_ptr = (char*)tile_out->output_buff;
-  size_t output_bytes= graph.output_bytes_per_task;
-  std::vector<const char *> input_ptrs;
-  std::vector<size_t> input_bytes;
-  input_ptrs.push_back((char*)tile_in1->output_buff);
-  input_bytes.push_back(graph.output_bytes_per_task);
-  input_ptrs.push_back((char*)tile_in2->output_buff);
-  input_bytes.push_back(graph.output_bytes_per_task);
-  input_ptrs.push_back((char*)tile_in3->output_buff);
-  input_bytes.push_back(graph.output_bytes_per_task);
-
-  graph.execute_point(payload.y, payload.x, output_ptr, output_bytes,
-                      input_ptrs.data(), input_bytes.data(), input_ptrs.size(), extra_local_memory[payload.graph_id][payload.x], graph.scratch_bytes_per_task);
+  const TaskGraph &graph = registered_task_graph(payload.graph_id);
+  char *scratch = scratch_pool.acquire(tid);
+  TaskArgs args;
+  args.reset(tile_out->output_buff, graph.task_output_bytes(payload.timestep, payload.point),
+             scratch, graph.scratch_bytes_per_task);
+  add_tile_input(args, graph, tile_in1, payload);
+  add_tile_input(args, graph, tile_in2, payload);
+  add_tile_input(args, graph, tile_in3, payload);
+  execute_point(payload, args);
+  scratch_pool.release(omp_get_thread_num(), scratch);
 #else
   tile_out->dep = tile_in1->dep + tile_in2->dep + tile_in3->dep + 1;
-  printf("Task4 tid %d, x %d, y %d, out %f, in1 %f, in2 %f, in3 %f\n", tid, payload.x, payload.y, tile_out->dep,tile_in1->dep, tile_in2->dep, tile_in3->dep);
+  printf("Task4 tid %d, x %ld, y %ld, out %f, in1 %f, in2 %f, in3 %f\n", tid, payload.point, payload.timestep, tile_out->dep,tile_in1->dep, tile_in2->dep, tile_in3->dep);
 #endif
 }
 
@@ -143,25 +144,20 @@ static inline void task5(tile_t *tile_out, tile_t *tile_in1, tile_t *tile_in2, t
 {
   int tid = omp_get_thread_num();
 #if defined (USE_CORE_VERIFICATION)    
-  TaskGraph graph = payload.graph;
-  char *output_ptr = (char*)tile_out->output_buff;
-  size_t output_bytes= graph.output_bytes_per_task;
-  std::vector<const char *> input_ptrs;
-  std::vector<size_t> input_bytes;
-  input_ptrs.push_back((char*)tile_in1->output_buff);
-  input_bytes.push_back(graph.output_bytes_per_task);
-  input_ptrs.push_back((char*)tile_in2->output_buff);
-  input_bytes.push_back(graph.output_bytes_per_task);
-  input_ptrs.push_back((char*)tile_in3->output_buff);
-  input_bytes.push_back(graph.output_bytes_per_task);
-  input_ptrs.push_back((char*)tile_in4->output_buff);
-  input_bytes.push_back(graph.output_bytes_per_task);
-
-  graph.execute_point(payload.y, payload.x, output_ptr, output_bytes,
-                      input_ptrs.data(), input_bytes.data(), input_ptrs.size(), extra_local_memory[payload.graph_id][payload.x], graph.scratch_bytes_per_task);
+  const TaskGraph &graph = registered_task_graph(payload.graph_id);
+  char *scratch = scratch_pool.acquire(tid);
+  TaskArgs args;
+  args.reset(tile_out->output_buff, graph.task_output_bytes(payload.timestep, payload.point),
+             scratch, graph.scratch_bytes_per_task);
+  add_tile_input(args, graph, tile_in1, payload);
+  add_tile_input(args, graph, tile_in2, payload);
+  add_tile_input(args, graph, tile_in3, payload);
+  add_tile_input(args, graph, tile_in4, payload);
+  execute_point(payload, args);
+  scratch_pool.release(omp_get_thread_num(), scratch);
 #else
   tile_out->dep = tile_in1->dep + tile_in2->dep + tile_in3->dep + tile_in4->dep + 1;
-  printf("Task5 tid %d, x %d, y %d, out %f, in1 %f, in2 %f, in3 %f, in4 %f\n", tid, payload.x, payload.y, tile_out->dep,tile_in1->dep, tile_in2->dep, tile_in3->dep, tile_in4->dep);
+  printf("Task5 tid %d, x %ld, y %ld, out %f, in1 %f, in2 %f, in3 %f, in4 %f\n", tid, payload.point, payload.timestep, tile_out->dep,tile_in1->dep, tile_in2->dep, tile_in3->dep, tile_in4->dep);
 #endif
 }
 
@@ -169,27 +165,21 @@ static inline void task6(tile_t *tile_out, tile_t *tile_in1, tile_t *tile_in2, t
 {
   int tid = omp_get_thread_num();
 #if defined (USE_CORE_VERIFICATION)    
-  TaskGraph graph = payload.graph;
-  char *output_ptr = (char*)tile_out->output_buff;
-  size_t output_bytes= graph.output_bytes_per_task;
-  std::vector<const char *> input_ptrs;
-  std::vector<size_t> input_bytes;
-  input_ptrs.push_back((char*)tile_in1->output_buff);
-  input_bytes.push_back(graph.output_bytes_per_task);
-  input_ptrs.push_back((char*)tile_in2->output_buff);
-  input_bytes.push_back(graph.output_bytes_per_task);
-  input_ptrs.push_back((char*)tile_in3->output_buff);
-  input_bytes.push_back(graph.output_bytes_per_task);
-  input_ptrs.push_back((char*)tile_in4->output_buff);
-  input_bytes.push_back(graph.output_bytes_per_task);
-  input_ptrs.push_back((char*)tile_in5->output_buff);
-  input_bytes.push_back(graph.output_bytes_per_task);
-
-  graph.execute_point(payload.y, payload.x, output_ptr, output_bytes,
-                      input_ptrs.data(), input_bytes.data(), input_ptrs.size(), extra_local_memory[payload.graph_id][payload.x], graph.scratch_bytes_per_task);
+  const TaskGraph &graph = registered_task_graph(payload.graph_id);
+  char *scratch = scratch_pool.acquire(tid);
+  TaskArgs args;
+  args.reset(tile_out->output_buff, graph.task_output_bytes(payload.timestep, payload.point),
+             scratch, graph.scratch_bytes_per_task);
+  add_tile_input(args, graph, tile_in1, payload);
+  add_tile_input(args, graph, tile_in2, payload);
+  add_tile_input(args, graph, tile_in3, payload);
+  add_tile_input(args, graph, tile_in4, payload);
+  add_tile_input(args, graph, tile_in5, payload);
+  execute_point(payload, args);
+  scratch_pool.release(omp_get_thread_num(), scratch);
 #else
   tile_out->dep = tile_in1->dep + tile_in2->dep + tile_in3->dep + tile_in4->dep + tile_in5->dep + 1;
-  printf("Task6 tid %d, x %d, y %d, out %f, in1 %f, in2 %f, in3 %f, in4 %f, in5 %f\n", tid, payload.x, payload.y, tile_out->dep,tile_in1->dep, tile_in2->dep, tile_in3->dep, tile_in4->dep, tile_in5->dep);
+  printf("Task6 tid %d, x %ld, y %ld, out %f, in1 %f, in2 %f, in3 %f, in4 %f, in5 %f\n", tid, payload.point, payload.timestep, tile_out->dep,tile_in1->dep, tile_in2->dep, tile_in3->dep, tile_in4->dep, tile_in5->dep);
 #endif
 }
 
@@ -197,30 +187,23 @@ static inline void task7(tile_t *tile_out, tile_t *tile_in1, tile_t *tile_in2, t
 {
   int tid = omp_get_thread_num();
 #if defined (USE_CORE_VERIFICATION)    
-  TaskGraph graph = payload.graph;
-  char *output_ptr = (char*)tile_out->output_buff;
-  size_t output_bytes= graph.output_bytes_per_task;
-  std::vector<const char *> input_ptrs;
-  std::vector<size_t> input_bytes;
-  input_ptrs.push_back((char*)tile_in1->output_buff);
-  input_bytes.push_back(graph.output_bytes_per_task);
-  input_ptrs.push_back((char*)tile_in2->output_buff);
-  input_bytes.push_back(graph.output_bytes_per_task);
-  input_ptrs.push_back((char*)tile_in3->output_buff);
-  input_bytes.push_back(graph.output_bytes_per_task);
-  input_ptrs.push_back((char*)tile_in4->output_buff);
-  input_bytes.push_back(graph.output_bytes_per_task);
-  input_ptrs.push_back((char*)tile_in5->output_buff);
-  input_bytes.push_back(graph.output_bytes_per_task);
-  input_ptrs.push_back((char*)tile_in6->output_buff);
-  input_bytes.push_back(graph.output_bytes_per_task);
-
-  graph.execute_point(payload.y, payload.x, output_ptr, output_bytes,
-                      input_ptrs.data(), input_bytes.data(), input_ptrs.size(), extra_local_memory[payload.graph_id][payload.x], graph.scratch_bytes_per_task);
+  const TaskGraph &graph = registered_task_graph(payload.graph_id);
+  char *scratch = scratch_pool.acquire(tid);
+  TaskArgs args;
+  args.reset(tile_out->output_buff, graph.task_output_bytes(payload.timestep, payload.point),
+             scratch, graph.scratch_bytes_per_task);
+  add_tile_input(args, graph, tile_in1, payload);
+  add_tile_input(args, graph, tile_in2, payload);
+  add_tile_input(args, graph, tile_in3, payload);
+  add_tile_input(args, graph, tile_in4, payload);
+  add_tile_input(args, graph, tile_in5, payload);
+  add_tile_input(args, graph, tile_in6, payload);
+  execute_point(payload, args);
+  scratch_pool.release(omp_get_thread_num(), scratch);
 #else
   tile_out->dep = tile_in1->dep + tile_in2->dep + tile_in3->dep + tile_in4->dep + tile_in5->dep + tile_in6->dep + 1;
-  printf("Task7 tid %d, x %d, y %d, out %f, in1 %f, in2 %f, in3 %f, in4 %f, in5 %f, in6 %f\n", 
-    tid, payload.x, payload.y, tile_out->dep,tile_in1->dep, tile_in2->dep, tile_in3->dep, tile_in4->dep, tile_in5->dep, tile_in6->dep);
+  printf("Task7 tid %d, x %ld, y %ld, out %f, in1 %f, in2 %f, in3 %f, in4 %f, in5 %f, in6 %f\n", 
+    tid, payload.point, payload.timestep, tile_out->dep,tile_in1->dep, tile_in2->dep, tile_in3->dep, tile_in4->dep, tile_in5->dep, tile_in6->dep);
 #endif
 }
 
@@ -228,32 +211,24 @@ static inline void task8(tile_t *tile_out, tile_t *tile_in1, tile_t *tile_in2, t
 {
   int tid = omp_get_thread_num();
 #if defined (USE_CORE_VERIFICATION)    
-  TaskGraph graph = payload.graph;
-  char *output_ptr = (char*)tile_out->output_buff;
-  size_t output_bytes= graph.output_bytes_per_task;
-  std::vector<const char *> input_ptrs;
-  std::vector<size_t> input_bytes;
-  input_ptrs.push_back((char*)tile_in1->output_buff);
-  input_bytes.push_back(graph.output_bytes_per_task);
-  input_ptrs.push_back((char*)tile_in2->output_buff);
-  input_bytes.push_back(graph.output_bytes_per_task);
-  input_ptrs.push_back((char*)tile_in3->output_buff);
-  input_bytes.push_back(graph.output_bytes_per_task);
-  input_ptrs.push_back((char*)tile_in4->output_buff);
-  input_bytes.push_back(graph.output_bytes_per_task);
-  input_ptrs.push_back((char*)tile_in5->output_buff);
-  input_bytes.push_back(graph.output_bytes_per_task);
-  input_ptrs.push_back((char*)tile_in6->output_buff);
-  input_bytes.push_back(graph.output_bytes_per_task);
-  input_ptrs.push_back((char*)tile_in7->output_buff);
-  input_bytes.push_back(graph.output_bytes_per_task);
-
-  graph.execute_point(payload.y, payload.x, output_ptr, output_bytes,
-                      input_ptrs.data(), input_bytes.data(), input_ptrs.size(), extra_local_memory[payload.graph_id][payload.x], graph.scratch_bytes_per_task);
+  const TaskGraph &graph = registered_task_graph(payload.graph_id);
+  char *scratch = scratch_pool.acquire(tid);
+  TaskArgs args;
+  args.reset(tile_out->output_buff, graph.task_output_bytes(payload.timestep, payload.point),
+             scratch, graph.scratch_bytes_per_task);
+  add_tile_input(args, graph, tile_in1, payload);
+  add_tile_input(args, graph, tile_in2, payload);
+  add_tile_input(args, graph, tile_in3, payload);
+  add_tile_input(args, graph, tile_in4, payload);
+  add_tile_input(args, graph, tile_in5, payload);
+  add_tile_input(args, graph, tile_in6, payload);
+  add_tile_input(args, graph, tile_in7, payload);
+  execute_point(payload, args);
+  scratch_pool.release(omp_get_thread_num(), scratch);
 #else
   tile_out->dep = tile_in1->dep + tile_in2->dep + tile_in3->dep + tile_in4->dep + tile_in5->dep + tile_in6->dep + tile_in7->dep + 1;
-  printf("Task8 tid %d, x %d, y %d, out %f, in1 %f, in2 %f, in3 %f, in4 %f, in5 %f, in6 %f, in7 %f\n", 
-    tid, payload.x, payload.y, tile_out->dep,tile_in1->dep, tile_in2->dep, tile_in3->dep, tile_in4->dep, tile_in5->dep, tile_in6->dep, tile_in7->dep);
+  printf("Task8 tid %d, x %ld, y %ld, out %f, in1 %f, in2 %f, in3 %f, in4 %f, in5 %f, in6 %f, in7 %f\n", 
+    tid, payload.point, payload.timestep, tile_out->dep,tile_in1->dep, tile_in2->dep, tile_in3->dep, tile_in4->dep, tile_in5->dep, tile_in6->dep, tile_in7->dep);
 #endif
 }
 
@@ -261,34 +236,25 @@ static inline void task9(tile_t *tile_out, tile_t *tile_in1, tile_t *tile_in2, t
 {
   int tid = omp_get_thread_num();
 #if defined (USE_CORE_VERIFICATION)    
-  TaskGraph graph = payload.graph;
-  char *output_ptr = (char*)tile_out->output_buff;
-  size_t output_bytes= graph.output_bytes_per_task;
-  std::vector<const char *> input_ptrs;
-  std::vector<size_t> input_bytes;
-  input_ptrs.push_back((char*)tile_in1->output_buff);
-  input_bytes.push_back(graph.output_bytes_per_task);
-  input_ptrs.push_back((char*)tile_in2->output_buff);
-  input_bytes.push_back(graph.output_bytes_per_task);
-  input_ptrs.push_back((char*)tile_in3->output_buff);
-  input_bytes.push_back(graph.output_bytes_per_task);
-  input_ptrs.push_back((char*)tile_in4->output_buff);
-  input_bytes.push_back(graph.output_bytes_per_task);
-  input_ptrs.push_back((char*)tile_in5->output_buff);
-  input_bytes.push_back(graph.output_bytes_per_task);
-  input_ptrs.push_back((char*)tile_in6->output_buff);
-  input_bytes.push_back(graph.output_bytes_per_task);
-  input_ptrs.push_back((char*)tile_in7->output_buff);
-  input_bytes.push_back(graph.output_bytes_per_task);
-  input_ptrs.push_back((char*)tile_in8->output_buff);
-  input_bytes.push_back(graph.output_bytes_per_task);
-
-  graph.execute_point(payload.y, payload.x, output_ptr, output_bytes,
-                      input_ptrs.data(), input_bytes.data(), input_ptrs.size(), extra_local_memory[payload.graph_id][payload.x], graph.scratch_bytes_per_task);
+  const TaskGraph &graph = registered_task_graph(payload.graph_id);
+  char *scratch = scratch_pool.acquire(tid);
+  TaskArgs args;
+  args.reset(tile_out->output_buff, graph.task_output_bytes(payload.timestep, payload.point),
+             scratch, graph.scratch_bytes_per_task);
+  add_tile_input(args, graph, tile_in1, payload);
+  add_tile_input(args, graph, tile_in2, payload);
+  add_tile_input(args, graph, tile_in3, payload);
+  add_tile_input(args, graph, tile_in4, payload);
+  add_tile_input(args, graph, tile_in5, payload);
+  add_tile_input(args, graph, tile_in6, payload);
+  add_tile_input(args, graph, tile_in7, payload);
+  add_tile_input(args, graph, tile_in8, payload);
+  execute_point(payload, args);
+  scratch_pool.release(omp_get_thread_num(), scratch);
 #else
   tile_out->dep = tile_in1->dep + tile_in2->dep + tile_in3->dep + tile_in4->dep + tile_in5->dep + tile_in6->dep + tile_in7->dep + tile_in8->dep + 1;
-  printf("Task9 tid %d, x %d, y %d, out %f, in1 %f, in2 %f, in3 %f, in4 %f, in5 %f, in6 %f, in7 %f, in8 %f\n", 
-    tid, payload.x, payload.y, tile_out->dep,tile_in1->dep, tile_in2->dep, tile_in3->dep, tile_in4->dep, tile_in5->dep, tile_in6->dep, tile_in7->dep, tile_in8->dep);
+  printf("Task9 tid %d, x %ld, y %ld, out %f, in1 %f, in2 %f, in3 %f, in4 %f, in5 %f, in6 %f, in7 %f, in8 %f\n", 
+    tid, payload.point, payload.timestep, tile_out->dep,tile_in1->dep, tile_in2->dep, tile_in3->dep, tile_in4->dep, tile_in5->dep, tile_in6->dep, tile_in7->dep, tile_in8->dep);
 #endif
 }
 
@@ -296,36 +262,26 @@ static inline void task10(tile_t *tile_out, tile_t *tile_in1, tile_t *tile_in2,
 {
   int tid = omp_get_thread_num();
 #if defined (USE_CORE_VERIFICATION)    
-  TaskGraph graph = payload.graph;
-  char *output_ptr = (char*)tile_out->output_buff;
-  size_t output_bytes= graph.output_bytes_per_task;
-  std::vector<const char *> input_ptrs;
-  std::vector<size_t> input_bytes;
-  input_ptrs.push_back((char*)tile_in1->output_buff);
-  input_bytes.push_back(graph.output_bytes_per_task);
-  input_ptrs.push_back((char*)tile_in2->output_buff);
-  input_bytes.push_back(graph.output_bytes_per_task);
-  input_ptrs.push_back((char*)tile_in3->output_buff);
-  input_bytes.push_back(graph.output_bytes_per_task);
-  input_ptrs.push_back((char*)tile_in4->output_buff);
-  input_bytes.push_back(graph.output_bytes_per_task);
-  input_ptrs.push_back((char*)tile_in5->output_buff);
-  input_bytes.push_back(graph.output_bytes_per_task);
-  input_ptrs.push_back((char*)tile_in6->output_buff);
-  input_bytes.push_back(graph.output_bytes_per_task);
-  input_ptrs.push_back((char*)tile_in7->output_buff);
-  input_bytes.push_back(graph.output_bytes_per_task);
-  input_ptrs.push_back((char*)tile_in8->output_buff);
-  input_bytes.push_back(graph.output_bytes_per_task);
-  input_ptrs.push_back((char*)tile_in9->output_buff);
-  input_bytes.push_back(graph.output_bytes_per_task);
-
-  graph.execute_point(payload.y, payload.x, output_ptr, output_bytes,
-                      input_ptrs.data(), input_bytes.data(), input_ptrs.size(), extra_local_memory[payload.graph_id][payload.x], graph.scratch_bytes_per_task);
+  const TaskGraph &graph = registered_task_graph(payload.graph_id);
+  char *scratch = scratch_pool.acquire(tid);
+  TaskArgs args;
+  args.reset(tile_out->output_buff, graph.task_output_bytes(payload.timestep, payload.point),
+             scratch, graph.scratch_bytes_per_task);
+  add_tile_input(args, graph, tile_in1, payload);
+  add_tile_input(args, graph, tile_in2, payload);
+  add_tile_input(args, graph, tile_in3, payload);
+  add_tile_input(args, graph, tile_in4, payload);
+  add_tile_input(args, graph, tile_in5, payload);
+  add_tile_input(args, graph, tile_in6, payload);
+  add_tile_input(args, graph, tile_in7, payload);
+  add_tile_input(args, graph, tile_in8, payload);
+  add_tile_input(args, graph, tile_in9, payload);
+  execute_point(payload, args);
+  scratch_pool.release(omp_get_thread_num(), scratch);
 #else
   tile_out->dep = tile_in1->dep + tile_in2->dep + tile_in3->dep + tile_in4->dep + tile_in5->dep + tile_in6->dep + tile_in7->dep + tile_in8->dep + tile_in9->dep + 1;
-  printf("Task10 tid %d, x %d, y %d, out %f, in1 %f, in2 %f, in3 %f, in4 %f, in5 %f, in6 %f, in7 %f, in8 %f, in9 %f\n", 
-    tid, payload.x, payload.y, tile_out->dep,tile_in1->dep, tile_in2->dep, tile_in3->dep, tile_in4->dep, tile_in5->dep, tile_in6->dep, tile_in7->dep, tile_in8->dep, tile_in9->dep);
+  printf("Task10 tid %d, x %ld, y %ld, out %f, in1 %f, in2 %f, in3 %f, in4 %f, in5 %f, in6 %f, in7 %f, in8 %f, in9 %f\n", 
+    tid, payload.point, payload.timestep, tile_out->dep,tile_in1->dep, tile_in2->dep, tile_in3->dep, tile_in4->dep, tile_in5->dep, tile_in6->dep, tile_in7->dep, tile_in8->dep, tile_in9->dep);
 #endif
 }
 
@@ -339,6 +295,9 @@ private:
   void debug_printf(int verbose_level, const char *format, ...);
 private:
   int nb_workers;
+  ThreadPinning *pinning;
+  // reused by execute_timestep so that no task allocates its dependencies
+  std::vector<std::pair<long, long> > deps_buffer;
 //  matrix_t *matrix;
 };
 
@@ -347,6 +306,7 @@ matrix_t *matrix = NULL;
 OpenMPApp::OpenMPApp(int argc, char **argv)
   : App(argc, argv)
 { 
+  use_min_fields();
   nb_workers = 1;
   
   for (int k = 1; k < argc; k++) {
@@ -357,29 +317,39 @@ OpenMPApp::OpenMPApp(int argc, char **argv)
   
   matrix = (matrix_t *)malloc(sizeof(matrix_t) * graphs.size());
   
+  size_t max_scratch_bytes_per_task = 0;
   
   for (unsigned i = 0; i < graphs.size(); i++) {
     TaskGraph &graph = graphs[i];
     
     matrix[i].M = graph.nb_fields;
     matrix[i].N = graph.max_width;
-    matrix[i].data = (tile_t*)malloc(sizeof(tile_t) * matrix[i].M * matrix[i].N);
+
+    for (long dset = 0; dset < graph.max_dependence_sets(); dset++) {
+      for (long x = 0; x < graph.max_width; x++) {
+        size_t max_deps = graph.num_dependencies(dset, x);
+        if (max_deps > deps_buffer.size()) {
+          deps_buffer.resize(max_deps);
+        }
+      }
+    }
+    size_t num_tiles = checked_mul(matrix[i].M, matrix[i].N, "tile matrix");
+    matrix[i].data = (tile_t*)malloc(checked_mul(sizeof(tile_t), num_tiles, "tile matrix"));
   
-    for (int j = 0; j < matrix[i].M * matrix[i].N; j++) {
-      matrix[i].data[j].output_buff = (char *)malloc(sizeof(char) * graph.output_bytes_per_task);
+    // one slab for all fields, each padded to a cache line
+    size_t field_bytes = (graph.max_output_bytes() + CACHE_LINE_SIZE - 1) & ~(size_t)(CACHE_LINE_SIZE - 1);
+    int ret = posix_memalign((void **)&matrix[i].buffer, CACHE_LINE_SIZE, checked_mul(field_bytes, num_tiles, "tile buffers"));
+    assert(ret == 0);
+    for (long j = 0; j < matrix[i].M * matrix[i].N; j++) {
+      matrix[i].data[j].point = j % matrix[i].N;
+      matrix[i].data[j].output_buff = matrix[i].buffer + j * field_bytes;
     }
     
-    extra_local_memory[i] = (char**)malloc(sizeof(char*) * graph.max_width);
-    assert(extra_local_memory[i] != NULL);
-    for (int k = 0; k < graph.max_width; k++) {
-      if (graph.scratch_bytes_per_task > 0) {
-        extra_local_memory[i][k] = (char*)malloc(sizeof(char)*graph.scratch_bytes_per_task);
-      } else {
-        extra_local_memory[i][k] = NULL;
-      }
+    if (graph.scratch_bytes_per_task > max_scratch_bytes_per_task) {
+      max_scratch_bytes_per_task = graph.scratch_bytes_per_task;
     }
     
-    printf("graph id %d, M = %d, N = %d, data %p, nb_fields %d\n", i, matrix[i].M, matrix[i].N, matrix[i].data, graph.nb_fields);
+    printf("graph id %d, M = %ld, N = %ld, data %p, nb_fields %d\n", i, matrix[i].M, matrix[i].N, matrix[i].data, graph.nb_fields);
   }
   
   
@@ -388,38 +358,38 @@ OpenMPApp::OpenMPApp(int argc, char **argv)
  // omp_set_dynamic(1);
   omp_set_num_threads(nb_workers);
   
-
+  scratch_pool.allocate(nb_workers, max_scratch_bytes_per_task, placement, huge_pages);
+  // Pin once here, before the first touch; the runtime keeps the
+  // same threads for later teams of the same size.
+  pinning = new ThreadPinning(pin_policy, pin_cpus, nb_workers);
+  #pragma omp parallel
+  {
+    pinning->pin(omp_get_thread_num());
+    scratch_pool.touch(omp_get_thread_num(), TaskGraph::prepare_scratch);
+  }
 }
 
 OpenMPApp::~OpenMPApp()
 {
   for (unsigned i = 0; i < graphs.size(); i++) {
-    for (int j = 0; j < matrix[i].M * matrix[i].N; j++) {
-      free(matrix[i].data[j].output_buff);
-      matrix[i].data[j].output_buff = NULL;
-    }
+    free(matrix[i].buffer);
+    matrix[i].buffer = NULL;
     free(matrix[i].data);
     matrix[i].data = NULL;
-    
-    TaskGraph &graph = graphs[i];
-    for (int j = 0; j < graph.max_width; j++) {
-      if (extra_local_memory[i][j] != NULL) {
-        free(extra_local_memory[i][j]);
-        extra_local_memory[i][j] = NULL;
-      }
-    }
-    free(extra_local_memory[i]);
-    extra_local_memory[i] = NULL;
   }
   
   free(matrix);
   matrix = NULL;
+
+  delete pinning;
+  pinning = NULL;
   
 }
 
 void OpenMPApp::execute_main_loop()
 { 
   display();
+  pinning->display();
   
   Timer::time_start();
   
@@ -429,7 +399,7 @@ void OpenMPApp::execute_main_loop()
     {
       for (unsigned i = 0; i < graphs.size(); i++) {
         const TaskGraph &g = graphs[i];
-        for (int y = 0; y < g.timesteps; y++) {
+        for (long y = 0; y < g.timesteps; y++) {
           execute_timestep(i, y);
         }
         
@@ -456,21 +426,22 @@ void OpenMPApp::execute_timestep(size_t idx, long t)
   int num_args = 0;
   int ct = 0;  
   
-  for (int x = offset; x <= offset+width-1; x++) {
-    std::vector<std::pair<long, long> > deps = g.dependencies(dset, x);   
+  for (long x = offset; x <= offset+width-1; x++) {
+    std::pair<long, long> *deps = deps_buffer.data();
+    size_t num_deps = g.dependencies(dset, x, deps);
     num_args = 0;
     ct = 0;    
     
-    if (deps.size() == 0) {
+    if (num_deps == 0) {
       num_args = 1;
-      debug_printf(1, "%d[%d] ", x, num_args);
+      debug_printf(1, "%ld[%d] ", x, num_args);
       args[ct].x = x;
       args[ct].y = t % nb_fields;
       ct ++;
     } else {
       if (t == 0) {
         num_args = 1;
-        debug_printf(1, "%d[%d] ", x, num_args);
+        debug_printf(1, "%ld[%d] ", x, num_args);
         args[ct].x = x;
         args[ct].y = t % nb_fields;
         ct ++;
@@ -481,10 +452,11 @@ void OpenMPApp::execute_timestep(size_t idx, long t)
         ct ++;
         long last_offset = g.offset_at_timestep(t-1);
         long last_width = g.width_at_timestep(t-1);
-        for (std::pair<long, long> dep : deps) {
+        for (size_t span = 0; span < num_deps; span++) {
+          std::pair<long, long> dep = deps[span];
           num_args += dep.second - dep.first + 1;
-          debug_printf(1, "%d[%d, %d, %d] ", x, num_args, dep.first, dep.second); 
-          for (int i = dep.first; i <= dep.second; i++) {
+          debug_printf(1, "%ld[%d, %ld, %ld] ", x, num_args, dep.first, dep.second); 
+          for (long i = dep.first; i <= dep.second; i++) {
             if (i >= last_offset && i < last_offset + last_width) {
               args[ct].x = i;
               args[ct].y = (t-1) % nb_fields;
@@ -499,10 +471,9 @@ void OpenMPApp::execute_timestep(size_t idx, long t)
     
     assert(num_args == ct);
     
-    payload.graph_id = idx;
-    payload.y = t;
-    payload.x = x;
-    payload.graph = g;
+    payload.timestep = t;
+    payload.point = x;
+    payload.graph_id = g.graph_index;
     insert_task(args, num_args, payload);
   }
 }
@@ -511,9 +482,9 @@ void OpenMPApp::insert_task(task_args_t *args, int num_args, payload_t payload)
 {
   int graph_id = payload.graph_id;
   tile_t *mat = matrix[graph_id].data;
-  int x0 = args[0].x;
-  int y0 = args[0].y;
-//  printf("x %d, y %d, mat %p\n", x0, y0, mat);
+  long x0 = args[0].x;
+  long y0 = args[0].y;
+//  printf("x %ld, y %ld, mat %p\n", x0, y0, mat);
   switch(num_args) {
   case 1:
   {
@@ -524,8 +495,8 @@ void OpenMPApp::insert_task(task_args_t *args, int num_args, payload_t payload)
   
   case 2: 
   {
-    int x1 = args[1].x;
-    int y1 = args[1].y;
+    long x1 = args[1].x;
+    long y1 = args[1].y;
     #pragma omp task depend(in: mat[y1 * matrix[graph_id].N + x1]) depend(inout: mat[y0 * matrix[graph_id].N + x0]) untied mergeable
       task2(&mat[y0 * matrix[graph_id].N + x0], 
             &mat[y1 * matrix[graph_id].N + x1], payload);
@@ -534,10 +505,10 @@ void OpenMPApp::insert_task(task_args_t *args, int num_args, payload_t payload)
   
   case 3: 
   {
-    int x1 = args[1].x;
-    int y1 = args[1].y;
-    int x2 = args[2].x;
-    int y2 = args[2].y;
+    long x1 = args[1].x;
+    long y1 = args[1].y;
+    long x2 = args[2].x;
+    long y2 = args[2].y;
     #pragma omp task depend(in: mat[y1 * matrix[graph_id].N + x1]) depend(in: mat[y2 * matrix[graph_id].N + x2]) depend(inout: mat[y0 * matrix[graph_id].N + x0]) untied mergeable
       task3(&mat[y0 * matrix[graph_id].N + x0], 
             &mat[y1 * matrix[graph_id].N + x1], 
@@ -547,12 +518,12 @@ void OpenMPApp::insert_task(task_args_t *args, int num_args, payload_t payload)
   
   case 4: 
   {
-    int x1 = args[1].x;
-    int y1 = args[1].y;
-    int x2 = args[2].x;
-    int y2 = args[2].y;
-    int x3 = args[3].x;
-    int y3 = args[3].y;
+    long x1 = args[1].x;
+    long y1 = args[1].y;
+    long x2 = args[2].x;
+    long y2 = args[2].y;
+    long x3 = args[3].x;
+    long y3 = args[3].y;
     #pragma omp task depend(in: mat[y1 * matrix[graph_id].N + x1]) depend(in: mat[y2 * matrix[graph_id].N + x2]) depend(in: mat[y3 * matrix[graph_id].N + x3]) depend(inout: mat[y0 * matrix[graph_id].N + x0]) untied mergeable
       task4(&mat[y0 * matrix[graph_id].N + x0], 
             &mat[y1 * matrix[graph_id].N + x1], 
@@ -563,14 +534,14 @@ void OpenMPApp::insert_task(task_args_t *args, int num_args, payload_t payload)
   
   case 5: 
   {
-    int x1 = args[1].x;
-    int y1 = args[1].y;
-    int x2 = args[2].x;
-    int y2 = args[2].y;
-    int x3 = args[3].x;
-    int y3 = args[3].y;
-    int x4 = args[4].x;
-    int y4 = args[4].y;
+    long x1 = args[1].x;
+    long y1 = args[1].y;
+    long x2 = args[2].x;
+    long y2 = args[2].y;
+    long x3 = args[3].x;
+    long y3 = args[3].y;
+    long x4 = args[4].x;
+    long y4 = args[4].y;
     #pragma omp task depend(in: mat[y1 * matrix[graph_id].N + x1]) depend(in: mat[y2 * matrix[graph_id].N + x2]) depend(in: mat[y3 * matrix[graph_id].N + x3]) depend(in: mat[y4 * matrix[graph_id].N + x4]) depend(inout: mat[y0 * matrix[graph_id].N + x0]) untied mergeable
       task5(&mat[y0 * matrix[graph_id].N + x0], 
             &mat[y1 * matrix[graph_id].N + x1], 
@@ -582,16 +553,16 @@ void OpenMPApp::insert_task(task_args_t *args, int num_args, payload_t payload)
   
   case 6: 
   {
-    int x1 = args[1].x;
-    int y1 = args[1].y;
-    int x2 = args[2].x;
-    int y2 = args[2].y;
-    int x3 = args[3].x;
-    int y3 = args[3].y;
-    int x4 = args[4].x;
-    int y4 = args[4].y;
-    int x5 = args[5].x;
-    int y5 = args[5].y;
+    long x1 = args[1].x;
+    long y1 = args[1].y;
+    long x2 = args[2].x;
+    long y2 = args[2].y;
+    long x3 = args[3].x;
+    long y3 = args[3].y;
+    long x4 = args[4].x;
+    long y4 = args[4].y;
+    long x5 = args[5].x;
+    long y5 = args[5].y;
     #pragma omp task depend(in: mat[y1 * matrix[graph_id].N + x1]) depend(in: mat[y2 * matrix[graph_id].N + x2]) depend(in: mat[y3 * matrix[graph_id].N + x3]) depend(in: mat[y4 * matrix[graph_id].N + x4]) depend(in: mat[y5 * matrix[graph_id].N + x5]) depend(inout: mat[y0 * matrix[graph_id].N + x0]) untied mergeable
       task6(&mat[y0 * matrix[graph_id].N + x0], 
             &mat[y1 * matrix[graph_id].N + x1], 
@@ -604,18 +575,18 @@ void OpenMPApp::insert_task(task_args_t *args, int num_args, payload_t payload)
   
   case 7: 
   {
-    int x1 = args[1].x;
-    int y1 = args[1].y;
-    int x2 = args[2].x;
-    int y2 = args[2].y;
-    int x3 = args[3].x;
-    int y3 = args[3].y;
-    int x4 = args[4].x;
-    int y4 = args[4].y;
-    int x5 = args[5].x;
-    int y5 = args[5].y;
-    int x6 = args[6].x;
-    int y6 = args[6].y;
+    long x1 = args[1].x;
+    long y1 = args[1].y;
+    long x2 = args[2].x;
+    long y2 = args[2].y;
+    long x3 = args[3].x;
+    long y3 = args[3].y;
+    long x4 = args[4].x;
+    long y4 = args[4].y;
+    long x5 = args[5].x;
+    long y5 = args[5].y;
+    long x6 = args[6].x;
+    long y6 = args[6].y;
     #pragma omp task depend(in: mat[y1 * matrix[graph_id].N + x1]) depend(in: mat[y2 * matrix[graph_id].N + x2]) depend(in: mat[y3 * matrix[graph_id].N + x3]) depend(in: mat[y4 * matrix[graph_id].N + x4]) depend(in: mat[y5 * matrix[graph_id].N + x5]) depend(in: mat[y6 * matrix[graph_id].N + x6]) depend(inout: mat[y0 * matrix[graph_id].N + x0]) untied mergeable
       task7(&mat[y0 * matrix[graph_id].N + x0], 
             &mat[y1 * matrix[graph_id].N + x1], 
@@ -629,20 +600,20 @@ void OpenMPApp::insert_task(task_args_t *args, int num_args, payload_t payload)
   
   case 8: 
   {
-    int x1 = args[1].x;
-    int y1 = args[1].y;
-    int x2 = args[2].x;
-    int y2 = args[2].y;
-    int x3 = args[3].x;
-    int y3 = args[3].y;
-    int x4 = args[4].x;
-    int y4 = args[4].y;
-    int x5 = args[5].x;
-    int y5 = args[5].y;
-    int x6 = args[6].x;
-    int y6 = args[6].y;
-    int x7 = args[7].x;
-    int y7 = args[7].y;
+    long x1 = args[1].x;
+    long y1 = args[1].y;
+    long x2 = args[2].x;
+    long y2 = args[2].y;
+    long x3 = args[3].x;
+    long y3 = args[3].y;
+    long x4 = args[4].x;
+    long y4 = args[4].y;
+    long x5 = args[5].x;
+    long y5 = args[5].y;
+    long x6 = args[6].x;
+    long y6 = args[6].y;
+    long x7 = args[7].x;
+    long y7 = args[7].y;
     #pragma omp task depend(in: mat[y1 * matrix[graph_id].N + x1]) depend(in: mat[y2 * matrix[graph_id].N + x2]) depend(in: mat[y3 * matrix[graph_id].N + x3]) depend(in: mat[y4 * matrix[graph_id].N + x4]) depend(in: mat[y5 * matrix[graph_id].N + x5]) depend(in: mat[y6 * matrix[graph_id].N + x6]) depend(in: mat[y7 * matrix[graph_id].N + x7]) depend(inout: mat[y0 * matrix[graph_id].N + x0]) untied mergeable
       task8(&mat[y0 * matrix[graph_id].N + x0], 
             &mat[y1 * matrix[graph_id].N + x1], 
@@ -657,22 +628,22 @@ void OpenMPApp::insert_task(task_args_t *args, int num_args, payload_t payload)
   
   case 9: 
   {
-    int x1 = args[1].x;
-    int y1 = args[1].y;
-    int x2 = args[2].x;
-    int y2 = args[2].y;
-    int x3 = args[3].x;
-    int y3 = args[3].y;
-    int x4 = args[4].x;
-    int y4 = args[4].y;
-    int x5 = args[5].x;
-    int y5 = args[5].y;
-    int x6 = args[6].x;
-    int y6 = args[6].y;
-    int x7 = args[7].x;
-    int y7 = args[7].y;
-    int x8 = args[8].x;
-    int y8 = args[8].y;
+    long x1 = args[1].x;
+    long y1 = args[1].y;
+    long x2 = args[2].x;
+    long y2 = args[2].y;
+    long x3 = args[3].x;
+    long y3 = args[3].y;
+    long x4 = args[4].x;
+    long y4 = args[4].y;
+    long x5 = args[5].x;
+    long y5 = args[5].y;
+    long x6 = args[6].x;
+    long y6 = args[6].y;
+    long x7 = args[7].x;
+    long y7 = args[7].y;
+    long x8 = args[8].x;
+    long y8 = args[8].y;
     #pragma omp task depend(in: mat[y1 * matrix[graph_id].N + x1]) depend(in: mat[y2 * matrix[graph_id].N + x2]) depend(in: mat[y3 * matrix[graph_id].N + x3]) depend(in: mat[y4 * matrix[graph_id].N + x4]) depend(in: mat[y5 * matrix[graph_id].N + x5]) depend(in: mat[y6 * matrix[graph_id].N + x6]) depend(in: mat[y7 * matrix[graph_id].N + x7]) depend(in: mat[y8 * matrix[graph_id].N + x8]) depend(inout: mat[y0 * matrix[graph_id].N + x0]) untied mergeable
       task9(&mat[y0 * matrix[graph_id].N + x0], 
             &mat[y1 * matrix[graph_id].N + x1], 
@@ -688,24 +659,24 @@ void OpenMPApp::insert_task(task_args_t *args, int num_args, payload_t payload)
   
   case 10: 
   {
-    int x1 = args[1].x;
-    int y1 = args[1].y;
-    int x2 = args[2].x;
-    int y2 = args[2].y;
-    int x3 = args[3].x;
-    int y3 = args[3].y;
-    int x4 = args[4].x;
-    int y4 = args[4].y;
-    int x5 = args[5].x;
-    int y5 = args[5].y;
-    int x6 = args[6].x;
-    int y6 = args[6].y;
-    int x7 = args[7].x;
-    int y7 = args[7].y;
-    int x8 = args[8].x;
-    int y8 = args[8].y;
-    int x9 = args[9].x;
-    int y9 = args[9].y;
+    long x1 = args[1].x;
+    long y1 = args[1].y;
+    long x2 = args[2].x;
+    long y2 = args[2].y;
+    long x3 = args[3].x;
+    long y3 = args[3].y;
+    long x4 = args[4].x;
+    long y4 = args[4].y;
+    long x5 = args[5].x;
+    long y5 = args[5].y;
+    long x6 = args[6].x;
+    long y6 = args[6].y;
+    long x7 = args[7].x;
+    long y7 = args[7].y;
+    long x8 = args[8].x;
+    long y8 = args[8].y;
+    long x9 = args[9].x;
+    long y9 = args[9].y;
     #pragma omp task depend(in: mat[y1 * matrix[graph_id].N + x1]) depend(in: mat[y2 * matrix[graph_id].N + x2]) depend(in: mat[y3 * matrix[graph_id].N + x3]) depend(in: mat[y4 * matrix[graph_id].N + x4]) depend(in: mat[y5 * matrix[graph_id].N + x5]) depend(in: mat[y6 * matrix[graph_id].N + x6]) depend(in: mat[y7 * matrix[graph_id].N + x7]) depend(in: mat[y8 * matrix[graph_id].N + x8]) depend(in: mat[y9 * matrix[graph_id].N + x9]) depend(inout: mat[y0 * matrix[graph_id].N + x0]) untied mergeable
       task10(&mat[y0 * matrix[graph_id].N + x0], 
             &mat[y1 * matrix[graph_id].N + x1], 
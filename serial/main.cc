@@ -1,302 +1,400 @@
 /* Copyright 2020 Los Alamos National Laboratory
  * Licensed under the Apache License, Version 2.0 */
 
-#include <stdarg.h>
 #include <assert.h>
 #include <string.h>
-#include <algorithm> 
-#include <unistd.h>
+#include <algorithm>
+#include <map>
+#include <string>
+#include <vector>
 #include "core.h"
 #include "timer.h"
-// #include "dash.h"
 
-#define VERBOSE_LEVEL 0
-#define USE_CORE_VERIFICATION
+// Single-core reference executor. Everything a task needs is computed
+// before the timer starts: the dependencies of every (dset, point) are
+// flattened into one index, outputs live in a ring of nb_fields rows
+// carved out of an arena, and inputs are gathered into reusable flat
+// arrays. The main loop therefore performs no allocation or I/O, and
+// its time is kernel time plus the cost of execute_point itself.
+//
+// Besides the plain timestep-by-timestep sweep, tasks can be visited in
+// several cache-friendlier orders. These split the graph into bands of
+// -order-band timesteps and keep band+1 output rows live, so any
+// topological order within a band is safe. Each order only requests
+// tasks; a depth-first walk runs a task's missing dependencies before
+// the task itself, so every order is legal for every pattern.
 
-extern "C" {
-typedef struct tile_s {
-  float dep;
-  char *output_buff;
-}tile_t;
+enum TraversalOrder {
+  ORDER_TIMESTEP, // one timestep at a time
+  ORDER_DEPTH_FIRST, // follow dependency chains back from the end of each band
+  ORDER_DIAGONAL, // skewed tiles of -order-tile points
+  ORDER_RECURSIVE, // cache-oblivious recursive split of (time, point)
+  ORDER_ALL, // run every order and report each speedup
+};
 
-typedef struct payload_s {
-  int x;
-  int y;
-  TaskGraph graph;
-}payload_t;
+static const std::map<std::string, TraversalOrder> order_by_name = {
+  {"timestep", ORDER_TIMESTEP},
+  {"depth_first", ORDER_DEPTH_FIRST},
+  {"diagonal", ORDER_DIAGONAL},
+  {"recursive", ORDER_RECURSIVE},
+  {"all", ORDER_ALL},
+};
 
-typedef struct matrix_s {
-  tile_t *data;
-  int M;
-  int N;
-}matrix_t;
+struct SerialGraph {
+  // Point q of timestep t is stored at output(t % nb_fields, q).
+  Arena outputs;
+  long nb_fields;
+  long width;
+  bool uniform_output;
 
-// Single scratch memory buffer for serial version
-char *scratch_memory = NULL;
+  // Dependencies of (dset, point) are the inclusive intervals
+  // dep_spans[dep_start[i] .. dep_start[i+1]) with i = dset * width +
+  // point, as returned by TaskGraph::dependencies. Keeping intervals
+  // rather than points keeps the index O(width) for dense patterns.
+  std::vector<size_t> dep_start;
+  std::vector<std::pair<long, long> > dep_spans;
 
-static inline void task1(tile_t *tile_out, payload_t payload)
-{
-  if (tile_out == NULL || tile_out->output_buff == NULL) {
-    fprintf(stderr, "Error: NULL pointer in task1 at position (%d, %d)\n", payload.x, payload.y);
-    return;
+  char *output(long timestep, long point) const
+  {
+    return outputs.block((timestep % nb_fields) * width + point);
   }
+};
 
-#if defined (USE_CORE_VERIFICATION)    
-  TaskGraph graph = payload.graph;
-  char *output_ptr = (char*)tile_out->output_buff;
-  size_t output_bytes = graph.output_bytes_per_task;
-  std::vector<const char *> input_ptrs;
-  std::vector<size_t> input_bytes;
-  input_ptrs.push_back((char*)tile_out->output_buff);
-  input_bytes.push_back(graph.output_bytes_per_task);
-  
-  graph.execute_point(payload.y, payload.x, output_ptr, output_bytes,
-                     input_ptrs.data(), input_bytes.data(), input_ptrs.size(), 
-                     scratch_memory, graph.scratch_bytes_per_task);
-#else  
-  tile_out->dep = 0;
-  printf("Task1 x %d, y %d, out %f\n", payload.x, payload.y, tile_out->dep);
-#endif  
-}
-
-static inline void task2(tile_t *tile_out, const std::vector<tile_t*> &tile_in, payload_t payload)
-{
-  if (tile_out == NULL || tile_out->output_buff == NULL) {
-    fprintf(stderr, "Error: NULL pointer in task2 output at position (%d, %d)\n", payload.x, payload.y);
-    return;
-  }
-
-#if defined (USE_CORE_VERIFICATION)    
-  TaskGraph graph = payload.graph;
-  char *output_ptr = (char*)tile_out->output_buff;
-  size_t output_bytes = graph.output_bytes_per_task;
-  std::vector<const char *> input_ptrs;
-  std::vector<size_t> input_bytes;
-  
-  // Add all input dependencies
-  for (size_t i = 0; i < tile_in.size(); i++) {
-    if (tile_in[i] == NULL || tile_in[i]->output_buff == NULL) {
-      fprintf(stderr, "Error: NULL pointer in task2 input %zu at position (%d, %d)\n", 
-              i, payload.x, payload.y);
-      return;
-    }
-    input_ptrs.push_back((char*)tile_in[i]->output_buff);
-    input_bytes.push_back(graph.output_bytes_per_task);
-  }
-  
-  graph.execute_point(payload.y, payload.x, output_ptr, output_bytes,
-                     input_ptrs.data(), input_bytes.data(), input_ptrs.size(), 
-                     scratch_memory, graph.scratch_bytes_per_task);
-#else  
-  tile_out->dep = 0;
-  for (size_t i = 0; i < tile_in.size(); i++) {
-    if (tile_in[i] == NULL) {
-      fprintf(stderr, "Error: NULL pointer in task2 input %zu at position (%d, %d)\n", 
-              i, payload.x, payload.y);
-      continue;
-    }
-    tile_out->dep += tile_in[i]->dep;
-  }
-  printf("Task2 x %d, y %d, out %f\n", payload.x, payload.y, tile_out->dep);
-#endif
-}
-
-// Similar modifications for task3-task10...
+struct Frame {
+  long timestep;
+  long point;
+  size_t next_span;
+  size_t end_span;
+  long next_dep; // within dep_spans[next_span]
+};
 
 struct SerialApp : public App {
   SerialApp(int argc, char **argv);
-  ~SerialApp();
   void execute_main_loop();
-  void execute_timestep(size_t idx, long t);
 private:
-  void debug_printf(int verbose_level, const char *format, ...);
+  double execute(TraversalOrder order);
+  void execute_graph(const TaskGraph &g, const SerialGraph &sg);
+  void execute_graph_banded(const TaskGraph &g, const SerialGraph &sg, TraversalOrder order);
+  void execute_task(const TaskGraph &g, const SerialGraph &sg,
+                    long t, long point, long last_offset, long last_width, long dset);
+  void request(const TaskGraph &g, const SerialGraph &sg, long r, long point);
+  void request_recursive(const TaskGraph &g, const SerialGraph &sg,
+                         long r0, long r1, long p0, long p1);
 private:
-  matrix_t *matrix;
+  TraversalOrder order;
+  long band;
+  long tile;
+  std::vector<SerialGraph> state;
+  Arena scratch;
+  size_t scratch_bytes;
+  std::vector<const char *> input_ptr;
+  std::vector<size_t> input_bytes;
+
+  // State of the current band: row r is timestep band_start + r.
+  long band_start;
+  std::vector<long> band_offset;
+  std::vector<long> band_width;
+  std::vector<long> band_dset;
+  std::vector<char> done;
+  std::vector<Frame> stack;
 };
 
 SerialApp::SerialApp(int argc, char **argv)
   : App(argc, argv)
-{ 
-  matrix = (matrix_t *)malloc(sizeof(matrix_t) * graphs.size());
-  
-  size_t max_scratch_bytes_per_task = 0;
-  
-  for (unsigned i = 0; i < graphs.size(); i++) {
-    TaskGraph &graph = graphs[i];
-    
-    matrix[i].M = graph.nb_fields;
-    matrix[i].N = graph.max_width;
-    matrix[i].data = (tile_t*)malloc(sizeof(tile_t) * matrix[i].M * matrix[i].N);
-  
-    for (int j = 0; j < matrix[i].M * matrix[i].N; j++) {
-      matrix[i].data[j].output_buff = (char *)malloc(sizeof(char) * graph.output_bytes_per_task);
+  , order(ORDER_TIMESTEP)
+  , band(16)
+  , tile(16)
+  , state(graphs.size())
+  , scratch_bytes(0)
+  , band_start(0)
+{
+  use_min_fields();
+
+  for (int i = 1; i < argc; i++) {
+    if (!strcmp(argv[i], "-order") && i + 1 < argc) {
+      auto name = order_by_name.find(argv[++i]);
+      if (name == order_by_name.end()) {
+        fprintf(stderr, "error: Invalid flag \"-order %s\"\n", argv[i]);
+        abort();
+      }
+      order = name->second;
+    }
+    if (!strcmp(argv[i], "-order-band") && i + 1 < argc) {
+      band = atol(argv[++i]);
+      if (band <= 0) {
+        fprintf(stderr, "error: Invalid flag \"-order-band %ld\" must be > 0\n", band);
+        abort();
+      }
+    }
+    if (!strcmp(argv[i], "-order-tile") && i + 1 < argc) {
+      tile = atol(argv[++i]);
+      if (tile <= 0) {
+        fprintf(stderr, "error: Invalid flag \"-order-tile %ld\" must be > 0\n", tile);
+        abort();
+      }
+    }
+  }
+
+  // before the buffers below are first touched
+  ThreadPinning(pin_policy, pin_cpus, 1).pin(0);
+
+  size_t max_inputs = 0;
+  long max_width = 0;
+
+  for (size_t i = 0; i < graphs.size(); i++) {
+    const TaskGraph &g = graphs[i];
+    SerialGraph &sg = state[i];
+
+    // Tasks run one at a time, so the minimum is enough in timestep
+    // order. Other orders keep a whole band plus its inputs live.
+    sg.nb_fields = std::max<long>(g.nb_fields, g.min_fields(1));
+    if (order != ORDER_TIMESTEP) {
+      sg.nb_fields = std::max(sg.nb_fields, std::min(band + 1, g.timesteps));
     }
-    
-    if (graph.scratch_bytes_per_task > max_scratch_bytes_per_task) {
-      max_scratch_bytes_per_task = graph.scratch_bytes_per_task;
+    sg.width = g.max_width;
+    sg.uniform_output = g.output_distribution == OutputDistribution::OUTPUT_UNIFORM;
+    sg.outputs.allocate(sg.nb_fields * sg.width, g.max_output_bytes(), placement, huge_pages);
+    if (placement == PLACEMENT_FIRST_TOUCH) {
+      sg.outputs.touch(0, sg.outputs.num_blocks());
     }
+
+    long dsets = g.max_dependence_sets();
+    sg.dep_start.reserve(dsets * sg.width + 1);
+    sg.dep_start.push_back(0);
+    for (long dset = 0; dset < dsets; dset++) {
+      for (long point = 0; point < sg.width; point++) {
+        size_t num_deps = 0;
+        for (auto interval : g.dependencies(dset, point)) {
+          sg.dep_spans.push_back(interval);
+          num_deps += interval.second - interval.first + 1;
+        }
+        max_inputs = std::max(max_inputs, num_deps);
+        sg.dep_start.push_back(sg.dep_spans.size());
+      }
+    }
+
+    scratch_bytes = std::max(scratch_bytes, g.scratch_bytes_per_task);
+    max_width = std::max(max_width, g.max_width);
   }
-  
-  if (max_scratch_bytes_per_task > 0) {
-    scratch_memory = (char*)malloc(sizeof(char)*max_scratch_bytes_per_task);
-    TaskGraph::prepare_scratch(scratch_memory, sizeof(char)*max_scratch_bytes_per_task);
+
+  if (order != ORDER_TIMESTEP) {
+    band_offset.resize(band);
+    band_width.resize(band);
+    band_dset.resize(band);
+    done.resize(band * max_width);
+    stack.reserve(band);
   }
+
+  input_ptr.resize(max_inputs);
+  input_bytes.resize(max_inputs);
+
+  scratch.allocate(1, scratch_bytes, placement, huge_pages);
+  TaskGraph::prepare_scratch(scratch.block(0), scratch_bytes);
 }
 
-SerialApp::~SerialApp()
+inline void SerialApp::execute_task(const TaskGraph &g, const SerialGraph &sg,
+                                    long t, long point, long last_offset, long last_width, long dset)
 {
-  for (unsigned i = 0; i < graphs.size(); i++) {
-    for (int j = 0; j < matrix[i].M * matrix[i].N; j++) {
-      free(matrix[i].data[j].output_buff);
-      matrix[i].data[j].output_buff = NULL;
+  const char **inputs = input_ptr.data();
+  size_t *sizes = input_bytes.data();
+
+  size_t n_inputs = 0;
+  if (t > 0) {
+    size_t idx = dset * sg.width + point;
+    const std::pair<long, long> *span = sg.dep_spans.data() + sg.dep_start[idx];
+    const std::pair<long, long> *span_end = sg.dep_spans.data() + sg.dep_start[idx+1];
+    for (; span != span_end; span++) {
+      long first = std::max(span->first, last_offset);
+      long last = std::min(span->second, last_offset + last_width - 1);
+      for (long dep = first; dep <= last; dep++) {
+        if (sg.uniform_output) {
+          inputs[n_inputs] = sg.output(t-1, dep);
+          sizes[n_inputs] = g.output_bytes_per_task;
+        } else {
+          inputs[n_inputs] = sg.output(t-1, dep) + g.output_field_offset(t-1, dep, point);
+          sizes[n_inputs] = g.output_field_bytes(t-1, dep, point);
+        }
+        n_inputs++;
+      }
     }
-    free(matrix[i].data);
-    matrix[i].data = NULL;
-  }
-  
-  free(matrix);
-  matrix = NULL;
-  
-  if (scratch_memory != NULL) {
-    free(scratch_memory);
-    scratch_memory = NULL;
   }
+
+  size_t output_bytes = sg.uniform_output ? g.output_bytes_per_task : g.task_output_bytes(t, point);
+  g.execute_point(t, point, sg.output(t, point), output_bytes,
+                  inputs, sizes, n_inputs,
+                  scratch.block(0), g.scratch_bytes_per_task);
 }
 
-void SerialApp::execute_main_loop()
-{ 
-  display();
-  
-  Timer::time_start();
-  
-  for (unsigned i = 0; i < graphs.size(); i++) {
-    const TaskGraph &g = graphs[i];
-    for (int y = 0; y < g.timesteps; y++) {
-      execute_timestep(i, y);
+void SerialApp::execute_graph(const TaskGraph &g, const SerialGraph &sg)
+{
+  for (long t = 0; t < g.timesteps; t++) {
+    long offset = g.offset_at_timestep(t);
+    long width = g.width_at_timestep(t);
+    long dset = g.dependence_set_at_timestep(t);
+    long last_offset = g.offset_at_timestep(t-1);
+    long last_width = g.width_at_timestep(t-1);
+
+    for (long point = offset; point < offset + width; point++) {
+      execute_task(g, sg, t, point, last_offset, last_width, dset);
     }
   }
-  
-  double elapsed = Timer::time_end();
-  report_timing(elapsed);
 }
 
-void SerialApp::execute_timestep(size_t idx, long t)
+// Runs (band_start + r, point) after any of its dependencies in the
+// current band that have not run yet.
+void SerialApp::request(const TaskGraph &g, const SerialGraph &sg, long r, long point)
 {
-  if (idx >= graphs.size()) {
-    fprintf(stderr, "Error: Invalid graph index %zu (max: %zu)\n", idx, graphs.size()-1);
-    return;
-  }
+  long width = sg.width;
+  if (done[r * width + point]) return;
 
-  const TaskGraph &g = graphs[idx];
-  long offset = g.offset_at_timestep(t);
-  long width = g.width_at_timestep(t);
-  long dset = g.dependence_set_at_timestep(t);
-  int nb_fields = g.nb_fields;
-  
-  if (matrix == NULL || matrix[idx].data == NULL) {
-    fprintf(stderr, "Error: NULL matrix data for graph %zu\n", idx);
-    return;
-  }
-  
-  if (nb_fields <= 0) {
-    fprintf(stderr, "Error: Invalid number of fields %d for graph %zu\n", nb_fields, idx);
-    return;
-  }
-  
-  payload_t payload;
-  payload.graph = g;
-  
-  for (int x = offset; x <= offset+width-1; x++) {
-    printf("timestep: %d, dep: %ld\n", t, x);
-    if (x < 0 || x >= matrix[idx].N) {
-      fprintf(stderr, "Error: x index %d out of bounds [0, %d) at timestep %ld\n", 
-              x, matrix[idx].N, t);
-      continue;
+  auto push = [&](long r, long point) {
+    Frame f = {r, point, 0, 0, 0};
+    if (r > 0) {
+      size_t idx = band_dset[r] * width + point;
+      f.next_span = sg.dep_start[idx];
+      f.end_span = sg.dep_start[idx+1];
+    }
+    stack.push_back(f);
+  };
+
+  push(r, point);
+  while (!stack.empty()) {
+    Frame &f = stack.back();
+    long fr = f.timestep;
+    long missing = -1;
+    while (f.next_span < f.end_span) {
+      const std::pair<long, long> &span = sg.dep_spans[f.next_span];
+      long dep = std::max(f.next_dep, std::max(span.first, band_offset[fr-1]));
+      long last = std::min(span.second, band_offset[fr-1] + band_width[fr-1] - 1);
+      while (dep <= last && done[(fr-1) * width + dep]) dep++;
+      if (dep <= last) {
+        missing = dep;
+        f.next_dep = dep + 1;
+        break;
+      }
+      f.next_span++;
+      f.next_dep = 0;
     }
-    
-    // NonKernelSplit();
-    std::vector<std::pair<long, long> > deps = g.dependencies(dset, x);   
-    
-    payload.x = x;
-    payload.y = t;
-    
-    int row_idx = t % nb_fields;
-    long array_idx = row_idx * matrix[idx].N + x;
-    
-    if (array_idx < 0 || array_idx >= matrix[idx].M * matrix[idx].N) {
-      fprintf(stderr, "Error: Array index %ld out of bounds [0, %d) at position (%d, %ld)\n", 
-              array_idx, matrix[idx].M * matrix[idx].N, x, t);
+    if (missing >= 0) {
+      push(fr - 1, missing);
       continue;
     }
-    
-    if (deps.size() == 0) {
-      // No dependencies, execute task1
-      task1(&matrix[idx].data[array_idx], payload);
-    } else {
-      if (t == 0) {
-        // First timestep, execute task1
-        task1(&matrix[idx].data[array_idx], payload);
-      } else {
-        // Handle dependencies
-        tile_t *out = &matrix[idx].data[array_idx];
-        std::vector<tile_t*> inputs;
-        
-        for (size_t i = 0; i < deps.size(); i++) {
-          long dep_x = deps[i].first;
-          
-          if (dep_x < 0 || dep_x >= matrix[idx].N) {
-            fprintf(stderr, "Error: Dependency x index %ld out of bounds [0, %d) at position (%d, %ld)\n", 
-                    dep_x, matrix[idx].N, x, t);
-            continue;
-          }
-          
-          int prev_row_idx = (t-1) % nb_fields;
-          long dep_array_idx = prev_row_idx * matrix[idx].N + dep_x;
-          
-          if (dep_array_idx < 0 || dep_array_idx >= matrix[idx].M * matrix[idx].N) {
-            fprintf(stderr, "Error: Dependency array index %ld out of bounds [0, %d) at position (%d, %ld)\n", 
-                    dep_array_idx, matrix[idx].M * matrix[idx].N, x, t);
-            continue;
+
+    long last_offset = fr > 0 ? band_offset[fr-1] : g.offset_at_timestep(band_start-1);
+    long last_width = fr > 0 ? band_width[fr-1] : g.width_at_timestep(band_start-1);
+    execute_task(g, sg, band_start + fr, f.point, last_offset, last_width, band_dset[fr]);
+    done[fr * width + f.point] = 1;
+    stack.pop_back();
+  }
+}
+
+void SerialApp::request_recursive(const TaskGraph &g, const SerialGraph &sg,
+                                  long r0, long r1, long p0, long p1)
+{
+  if (r1 - r0 == 1 && p1 - p0 <= tile) {
+    long first = std::max(p0, band_offset[r0]);
+    long last = std::min(p1, band_offset[r0] + band_width[r0]);
+    for (long point = first; point < last; point++) {
+      request(g, sg, r0, point);
+    }
+  } else if (r1 - r0 > 1 && r1 - r0 >= (p1 - p0) / tile) {
+    long rm = (r0 + r1) / 2;
+    request_recursive(g, sg, r0, rm, p0, p1);
+    request_recursive(g, sg, rm, r1, p0, p1);
+  } else {
+    long pm = (p0 + p1) / 2;
+    request_recursive(g, sg, r0, r1, p0, pm);
+    request_recursive(g, sg, r0, r1, pm, p1);
+  }
+}
+
+void SerialApp::execute_graph_banded(const TaskGraph &g, const SerialGraph &sg, TraversalOrder order)
+{
+  long width = sg.width;
+  for (band_start = 0; band_start < g.timesteps; band_start += band) {
+    long rows = std::min(band, g.timesteps - band_start);
+    for (long r = 0; r < rows; r++) {
+      band_offset[r] = g.offset_at_timestep(band_start + r);
+      band_width[r] = g.width_at_timestep(band_start + r);
+      band_dset[r] = g.dependence_set_at_timestep(band_start + r);
+    }
+    std::fill(done.begin(), done.begin() + rows * width, 0);
+
+    switch (order) {
+    case ORDER_DEPTH_FIRST:
+      for (long point = band_offset[rows-1]; point < band_offset[rows-1] + band_width[rows-1]; point++) {
+        request(g, sg, rows - 1, point);
+      }
+      break;
+    case ORDER_DIAGONAL:
+      {
+        long tiles = (width + tile - 1) / tile;
+        for (long diagonal = 0; diagonal < tiles + rows - 1; diagonal++) {
+          for (long r = 0; r < rows; r++) {
+            long j = diagonal - r;
+            if (j < 0 || j >= tiles) continue;
+            long first = std::max(j * tile, band_offset[r]);
+            long last = std::min((j + 1) * tile, band_offset[r] + band_width[r]);
+            for (long point = first; point < last; point++) {
+              request(g, sg, r, point);
+            }
           }
-          
-          inputs.push_back(&matrix[idx].data[dep_array_idx]);
         }
-        
-        task2(out, inputs, payload);
       }
-    } 
-    // NonKernelSplit();
+      break;
+    case ORDER_RECURSIVE:
+      request_recursive(g, sg, 0, rows, 0, width);
+      break;
+    default:
+      assert(false && "unexpected traversal order");
+    }
+
+    // Pick up anything the order did not reach (e.g. points that are
+    // not ancestors of the last row when the width varies).
+    for (long r = 0; r < rows; r++) {
+      for (long point = band_offset[r]; point < band_offset[r] + band_width[r]; point++) {
+        request(g, sg, r, point);
+      }
+    }
   }
 }
 
-void SerialApp::debug_printf(int verbose_level, const char *format, ...)
+double SerialApp::execute(TraversalOrder order)
 {
-  if (verbose_level > VERBOSE_LEVEL) {
+  Timer::time_start();
+  for (size_t i = 0; i < graphs.size(); i++) {
+    if (order == ORDER_TIMESTEP) {
+      execute_graph(graphs[i], state[i]);
+    } else {
+      execute_graph_banded(graphs[i], state[i], order);
+    }
+  }
+  return Timer::time_end();
+}
+
+void SerialApp::execute_main_loop()
+{
+  display();
+  ThreadPinning(pin_policy, pin_cpus, 1).display();
+
+  if (order != ORDER_ALL) {
+    report_timing(execute(order));
     return;
   }
-  va_list args;
-  va_start(args, format);
-  vprintf(format, args);
-  va_end(args);
+
+  double baseline = execute(ORDER_TIMESTEP);
+  printf("Traversal Orders:\n");
+  printf("  timestep: %e seconds\n", baseline);
+  for (auto name : {"depth_first", "diagonal", "recursive"}) {
+    double elapsed = execute(order_by_name.at(name));
+    printf("  %s: %e seconds, speedup %.3f\n", name, elapsed, baseline / elapsed);
+  }
+  report_timing(baseline);
 }
 
-int main(int argc, char ** argv)
+int main(int argc, char **argv)
 {
-  argc = 8;
-  argv[0] = "-steps";
-  argv[1] = "2";
-  argv[2] = "-width";
-  argv[3] = "2";
-  argv[4] = "-type";
-  argv[5] = "stencil_1d";
-  argv[6] = "-kernel";
-  argv[7] = "compute_bound";
-  argv[8] = "-iter";
-  argv[9] = "4096";
-  argv[10] = "-worker";
-  argv[11] = "1";
   SerialApp app(argc, argv);
   app.execute_main_loop();
   return 0;
 }
-}
\ No newline at end of file
@@ -0,0 +1,531 @@
+/* Copyright 2020 Stanford University
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <memory>
+#include <new>
+#include <vector>
+#include <sched.h>
+#include <sys/mman.h>
+#include <sys/wait.h>
+#ifdef __linux__
+#include <linux/futex.h>
+#include <sys/syscall.h>
+#endif
+#include "core.h"
+#include "core_executor.h"
+
+// Distributed-style executor on one machine. The driver forks -proc
+// processes, each owning a contiguous block of points as an MPI rank
+// would (see mpi/nonblock.cc). Processes share nothing but one
+// anonymous shared mapping holding a single-producer/single-consumer
+// mailbox for every ordered pair of processes, one doorbell per
+// process, and a barrier used to time the run.
+//
+// After running a task, a process sends its output once to every
+// other process that owns a consumer. Before running timestep t, it
+// drains exactly the messages from timestep t-1 it needs. Mailboxes
+// hold two timesteps' worth of messages, which is enough for the
+// slowest process to never block the others indefinitely. Idle
+// receivers sleep on their doorbell with a futex.
+//
+// -latency and -bandwidth delay the delivery of every message as if
+// it crossed a link with that latency and bandwidth, so overlap and
+// partitioning can be studied without a network.
+
+#define SPINS_BEFORE_SLEEP 1024
+
+static inline double now()
+{
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+// Futexes in a MAP_SHARED mapping, so not FUTEX_PRIVATE_FLAG.
+static void futex_wait(std::atomic<uint32_t> *addr, uint32_t expected)
+{
+#ifdef __linux__
+  syscall(SYS_futex, reinterpret_cast<uint32_t *>(addr), FUTEX_WAIT, expected, NULL, NULL, 0);
+#else
+  sched_yield();
+#endif
+}
+
+static void futex_wake(std::atomic<uint32_t> *addr)
+{
+#ifdef __linux__
+  syscall(SYS_futex, reinterpret_cast<uint32_t *>(addr), FUTEX_WAKE, INT32_MAX, NULL, NULL, 0);
+#endif
+}
+
+// Rung by senders after every message. A receiver with nothing to do
+// records the count, announces that it is sleeping, rechecks its
+// mailboxes and then waits for the count to change.
+struct alignas(CACHE_LINE_SIZE) Doorbell {
+  std::atomic<uint32_t> rings;
+  std::atomic<uint32_t> sleeping;
+};
+
+struct MessageHeader {
+  long graph_index;
+  long timestep;
+  long point;
+  size_t bytes;
+  double deliver_at;
+};
+
+// head and tail count messages ever consumed and produced; slot i lives
+// at i % capacity. A producer finding the mailbox full sleeps on head.
+struct Mailbox {
+  alignas(CACHE_LINE_SIZE) std::atomic<uint32_t> tail;
+  alignas(CACHE_LINE_SIZE) std::atomic<uint32_t> head;
+  std::atomic<uint32_t> producer_sleeping;
+};
+
+struct SharedRegion {
+  int num_procs;
+  uint32_t capacity;
+  size_t slot_bytes;
+  char *base;
+  size_t bytes;
+
+  Doorbell *doorbells;
+  Mailbox *mailboxes; // [from * num_procs + to]
+  char *slots;
+  SpinBarrier *barrier;
+
+  void allocate(int procs, uint32_t mailbox_capacity, size_t max_message_bytes)
+  {
+    num_procs = procs;
+    capacity = mailbox_capacity;
+    slot_bytes = (sizeof(MessageHeader) + max_message_bytes + CACHE_LINE_SIZE - 1) / CACHE_LINE_SIZE * CACHE_LINE_SIZE;
+
+    size_t doorbell_bytes = sizeof(Doorbell) * procs;
+    size_t mailbox_bytes = sizeof(Mailbox) * procs * procs;
+    size_t slots_bytes = slot_bytes * capacity * procs * procs;
+    bytes = doorbell_bytes + mailbox_bytes + slots_bytes + sizeof(SpinBarrier);
+
+    void *mapping = mmap(NULL, bytes, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+    if (mapping == MAP_FAILED) {
+      fprintf(stderr, "error: Unable to map %zu bytes of shared memory (%s)\n", bytes, strerror(errno));
+      abort();
+    }
+    base = reinterpret_cast<char *>(mapping);
+
+    doorbells = reinterpret_cast<Doorbell *>(base);
+    mailboxes = reinterpret_cast<Mailbox *>(base + doorbell_bytes);
+    slots = base + doorbell_bytes + mailbox_bytes;
+    for (int i = 0; i < procs; i++) {
+      new (&doorbells[i]) Doorbell;
+      doorbells[i].rings.store(0);
+      doorbells[i].sleeping.store(0);
+    }
+    for (int i = 0; i < procs * procs; i++) {
+      new (&mailboxes[i]) Mailbox;
+      mailboxes[i].tail.store(0);
+      mailboxes[i].head.store(0);
+      mailboxes[i].producer_sleeping.store(0);
+    }
+    barrier = new (slots + slots_bytes) SpinBarrier(procs);
+  }
+
+  Mailbox &mailbox(int from, int to) const { return mailboxes[from * num_procs + to]; }
+
+  char *slot(int from, int to, uint32_t index) const
+  {
+    return slots + ((size_t(from) * num_procs + to) * capacity + index % capacity) * slot_bytes;
+  }
+};
+
+struct ShmemGraph {
+  TaskGraph graph;
+  GraphIndex index;
+  long first_point;
+  long last_point; // exclusive
+  std::vector<int> owner;
+
+  // Outputs of our points for timesteps t % 2, and the latest output
+  // received for every remote point.
+  Arena outputs;
+  Arena remote;
+
+  ShmemGraph(const TaskGraph &graph, int rank, int num_procs,
+             ArenaPlacement placement, bool huge_pages)
+    : graph(graph)
+    , index(graph)
+    , first_point(rank * graph.max_width / num_procs)
+    , last_point((rank + 1) * graph.max_width / num_procs)
+    , owner(graph.max_width)
+  {
+    for (int r = 0; r < num_procs; r++) {
+      for (long p = r * graph.max_width / num_procs; p < (r + 1) * graph.max_width / num_procs; p++) {
+        owner[p] = r;
+      }
+    }
+    outputs.allocate(2 * (last_point - first_point), graph.max_output_bytes(), placement, huge_pages);
+    outputs.touch(0, outputs.num_blocks());
+    remote.allocate(graph.max_width, graph.max_output_bytes(), placement, huge_pages);
+    remote.touch(0, remote.num_blocks());
+  }
+
+  char *output(long timestep, long point) const
+  {
+    if (point >= first_point && point < last_point) {
+      return outputs.block((timestep % 2) * (last_point - first_point) + point - first_point);
+    }
+    return remote.block(point);
+  }
+};
+
+struct ShmemApp : public App {
+  ShmemApp(int argc, char **argv);
+  void execute_main_loop();
+private:
+  void initialize_process(int rank);
+  double execute_graph(ShmemGraph &sg);
+  void send(ShmemGraph &sg, int to, long timestep, long point);
+  bool try_receive(ShmemGraph &sg, int from, long timestep, double &wait_until);
+  void receive(ShmemGraph &sg, long timestep);
+private:
+  int nb_procs;
+  double latency;
+  double bandwidth;
+  SharedRegion region;
+
+  // per process, after fork
+  int rank;
+  std::vector<std::unique_ptr<ShmemGraph>> state;
+  Arena scratch;
+  std::vector<const char *> input_ptr;
+  std::vector<size_t> input_bytes;
+  std::vector<double> link_free_at;
+  std::vector<long> expected;
+  std::vector<long> stamp;
+};
+
+ShmemApp::ShmemApp(int argc, char **argv)
+  : App(argc, argv)
+  , nb_procs(1)
+  , latency(0)
+  , bandwidth(0)
+  , rank(0)
+{
+  for (int i = 1; i < argc; i++) {
+    if (!strcmp(argv[i], "-proc") && i + 1 < argc) {
+      nb_procs = atol(argv[++i]);
+      if (nb_procs <= 0) {
+        fprintf(stderr, "error: Invalid flag \"-proc %d\" must be > 0\n", nb_procs);
+        abort();
+      }
+    }
+    if (!strcmp(argv[i], "-latency") && i + 1 < argc) {
+      latency = atof(argv[++i]) * 1e-6;
+      if (latency < 0) {
+        fprintf(stderr, "error: Invalid flag \"-latency %s\" must be >= 0\n", argv[i]);
+        abort();
+      }
+    }
+    if (!strcmp(argv[i], "-bandwidth") && i + 1 < argc) {
+      bandwidth = atof(argv[++i]) * 1e6;
+      if (bandwidth <= 0) {
+        fprintf(stderr, "error: Invalid flag \"-bandwidth %s\" must be > 0\n", argv[i]);
+        abort();
+      }
+    }
+  }
+
+  // Each sender sends at most one message per point it owns per
+  // timestep, and a receiver is never more than one timestep behind
+  // the messages it still needs, so two timesteps' worth suffices.
+  long max_block = 0;
+  size_t max_message_bytes = 0;
+  for (auto g : graphs) {
+    if (g.max_width < nb_procs) {
+      fprintf(stderr, "error: Graph width %ld is smaller than the number of processes %d\n",
+              g.max_width, nb_procs);
+      abort();
+    }
+    max_block = std::max(max_block, (g.max_width + nb_procs - 1) / nb_procs);
+    max_message_bytes = std::max(max_message_bytes, g.max_output_bytes());
+  }
+  uint32_t capacity = 1;
+  while (capacity < 2 * max_block + 1) {
+    capacity *= 2;
+  }
+  region.allocate(nb_procs, capacity, max_message_bytes);
+}
+
+void ShmemApp::send(ShmemGraph &sg, int to, long timestep, long point)
+{
+  Mailbox &box = region.mailbox(rank, to);
+  uint32_t tail = box.tail.load(std::memory_order_relaxed);
+  int spins = 0;
+  while (tail - box.head.load(std::memory_order_acquire) >= region.capacity) {
+    if (++spins < SPINS_BEFORE_SLEEP) continue;
+    uint32_t head = box.head.load(std::memory_order_seq_cst);
+    box.producer_sleeping.store(1, std::memory_order_seq_cst);
+    if (tail - box.head.load(std::memory_order_seq_cst) >= region.capacity) {
+      futex_wait(&box.head, head);
+    }
+    box.producer_sleeping.store(0, std::memory_order_relaxed);
+    spins = 0;
+  }
+
+  const TaskGraph &g = sg.graph;
+  size_t bytes = g.output_distribution == OutputDistribution::OUTPUT_UNIFORM
+    ? g.output_bytes_per_task : g.task_output_bytes(timestep, point);
+
+  // Model a link per destination: messages queue behind each other at
+  // the given bandwidth, then take the given latency.
+  double deliver_at = 0;
+  if (latency > 0 || bandwidth > 0) {
+    double start = std::max(now(), link_free_at[to]);
+    double done = start + (bandwidth > 0 ? bytes / bandwidth : 0);
+    link_free_at[to] = done;
+    deliver_at = done + latency;
+  }
+
+  char *slot = region.slot(rank, to, tail);
+  MessageHeader *header = reinterpret_cast<MessageHeader *>(slot);
+  header->graph_index = g.graph_index;
+  header->timestep = timestep;
+  header->point = point;
+  header->bytes = bytes;
+  header->deliver_at = deliver_at;
+  memcpy(slot + sizeof(MessageHeader), sg.output(timestep, point), bytes);
+  box.tail.store(tail + 1, std::memory_order_seq_cst);
+
+  Doorbell &bell = region.doorbells[to];
+  bell.rings.fetch_add(1, std::memory_order_seq_cst);
+  if (bell.sleeping.load(std::memory_order_seq_cst)) {
+    futex_wake(&bell.rings);
+  }
+}
+
+bool ShmemApp::try_receive(ShmemGraph &sg, int from, long timestep, double &wait_until)
+{
+  Mailbox &box = region.mailbox(from, rank);
+  uint32_t head = box.head.load(std::memory_order_relaxed);
+  if (box.tail.load(std::memory_order_acquire) == head) {
+    return false;
+  }
+
+  char *slot = region.slot(from, rank, head);
+  MessageHeader *header = reinterpret_cast<MessageHeader *>(slot);
+  if (header->deliver_at > 0 && now() < header->deliver_at) {
+    wait_until = std::min(wait_until, header->deliver_at);
+    return false;
+  }
+  if (header->graph_index != sg.graph.graph_index || header->timestep != timestep) {
+    fprintf(stderr, "error: Process %d expected a message for graph %ld timestep %ld from process %d, got graph %ld timestep %ld\n",
+            rank, sg.graph.graph_index, timestep, from, header->graph_index, header->timestep);
+    abort();
+  }
+  memcpy(sg.remote.block(header->point), slot + sizeof(MessageHeader), header->bytes);
+  box.head.store(head + 1, std::memory_order_seq_cst);
+  if (box.producer_sleeping.load(std::memory_order_seq_cst)) {
+    futex_wake(&box.head);
+  }
+  return true;
+}
+
+void ShmemApp::receive(ShmemGraph &sg, long timestep)
+{
+  // Count the remote outputs of timestep - 1 that our points at
+  // timestep consume, once per producing point.
+  const GraphIndex &index = sg.index;
+  long outstanding = 0;
+  std::fill(expected.begin(), expected.end(), 0);
+  long first = std::max(sg.first_point, index.row_offset[timestep]);
+  long last = std::min(sg.last_point, index.row_offset[timestep] + index.row_width[timestep]);
+  for (long point = first; point < last; point++) {
+    size_t idx = index.dep_index(timestep, point);
+    for (size_t i = index.dep_start[idx]; i < index.dep_start[idx + 1]; i++) {
+      std::pair<long, long> deps = index.clip(timestep - 1, index.dep_spans[i]);
+      for (long dep = deps.first; dep <= deps.second; dep++) {
+        if (sg.owner[dep] == rank || stamp[dep] == timestep) continue;
+        stamp[dep] = timestep;
+        expected[sg.owner[dep]]++;
+        outstanding++;
+      }
+    }
+  }
+
+  Doorbell &bell = region.doorbells[rank];
+  int spins = 0;
+  while (outstanding > 0) {
+    uint32_t rings = bell.rings.load(std::memory_order_seq_cst);
+    double wait_until = HUGE_VAL;
+    bool progress = false;
+    for (int from = 0; from < nb_procs; from++) {
+      while (expected[from] > 0 && try_receive(sg, from, timestep - 1, wait_until)) {
+        expected[from]--;
+        outstanding--;
+        progress = true;
+      }
+    }
+    if (progress || outstanding == 0) {
+      spins = 0;
+      continue;
+    }
+
+    if (wait_until < HUGE_VAL) {
+      // A message is here but not due yet.
+      double delay = wait_until - now();
+      if (delay > 50e-6) {
+        struct timespec ts = {0, long(delay * 1e9)};
+        nanosleep(&ts, NULL);
+      }
+    } else if (++spins >= SPINS_BEFORE_SLEEP) {
+      bell.sleeping.store(1, std::memory_order_seq_cst);
+      if (bell.rings.load(std::memory_order_seq_cst) == rings) {
+        futex_wait(&bell.rings, rings);
+      }
+      bell.sleeping.store(0, std::memory_order_relaxed);
+      spins = 0;
+    }
+  }
+}
+
+double ShmemApp::execute_graph(ShmemGraph &sg)
+{
+  const GraphIndex &index = sg.index;
+  std::fill(stamp.begin(), stamp.end(), -1);
+  std::vector<long> dest_stamp(nb_procs, -1);
+
+  region.barrier->wait();
+  double start = now();
+
+  for (long t = 0; t < index.timesteps; t++) {
+    if (t > 0) {
+      receive(sg, t);
+    }
+
+    long first = std::max(sg.first_point, index.row_offset[t]);
+    long last = std::min(sg.last_point, index.row_offset[t] + index.row_width[t]);
+    for (long point = first; point < last; point++) {
+      execute_indexed(sg.graph, index, t, point,
+                      [&sg](long timestep, long p) { return sg.output(timestep, p); },
+                      input_ptr.data(), input_bytes.data(), scratch.block(0));
+
+      // Send the output once to every other process with a consumer.
+      if (t + 1 < index.timesteps) {
+        size_t ridx = index.dep_index(t + 1, point);
+        for (size_t i = index.rdep_start[ridx]; i < index.rdep_start[ridx + 1]; i++) {
+          std::pair<long, long> consumers = index.clip(t + 1, index.rdep_spans[i]);
+          for (long consumer = consumers.first; consumer <= consumers.second; consumer++) {
+            int to = sg.owner[consumer];
+            if (to == rank || dest_stamp[to] == t * index.width + point) continue;
+            dest_stamp[to] = t * index.width + point;
+            send(sg, to, t, point);
+          }
+        }
+      }
+    }
+  }
+
+  region.barrier->wait();
+  return now() - start;
+}
+
+void ShmemApp::initialize_process(int process_rank)
+{
+  rank = process_rank;
+  ThreadPinning(pin_policy, pin_cpus, nb_procs).pin(rank);
+  link_free_at.assign(nb_procs, 0);
+  expected.assign(nb_procs, 0);
+
+  // Everything below is private to this process.
+  size_t max_inputs = 0;
+  size_t scratch_bytes = 0;
+  long max_width = 0;
+  for (auto g : graphs) {
+    state.emplace_back(new ShmemGraph(g, rank, nb_procs, placement, huge_pages));
+    max_inputs = std::max(max_inputs, state.back()->index.max_inputs);
+    scratch_bytes = std::max(scratch_bytes, g.scratch_bytes_per_task);
+    max_width = std::max(max_width, g.max_width);
+  }
+  input_ptr.resize(max_inputs);
+  input_bytes.resize(max_inputs);
+  stamp.resize(max_width);
+
+  scratch.allocate(1, scratch_bytes, placement, huge_pages);
+  scratch.touch(0, 1);
+  TaskGraph::prepare_scratch(scratch.block(0), scratch_bytes);
+}
+
+void ShmemApp::execute_main_loop()
+{
+  display();
+  printf("Processes: %d\n", nb_procs);
+  ThreadPinning(pin_policy, pin_cpus, nb_procs).display();
+  fflush(stdout);
+
+  std::vector<pid_t> children;
+  for (int r = 1; r < nb_procs; r++) {
+    pid_t pid = fork();
+    if (pid < 0) {
+      fprintf(stderr, "error: Unable to fork process %d (%s)\n", r, strerror(errno));
+      abort();
+    }
+    if (pid == 0) {
+      rank = r;
+      break;
+    }
+    children.push_back(pid);
+  }
+
+  initialize_process(rank);
+
+  // As in mpi/nonblock.cc, the first iteration is a warm-up.
+  double elapsed = 0;
+  for (int iter = 0; iter < 2; iter++) {
+    elapsed = 0;
+    for (auto &sg : state) {
+      elapsed += execute_graph(*sg);
+    }
+  }
+
+  if (rank != 0) {
+    fflush(stdout);
+    _exit(0);
+  }
+
+  for (auto pid : children) {
+    int status;
+    if (waitpid(pid, &status, 0) < 0 || !WIFEXITED(status) || WEXITSTATUS(status) != 0) {
+      fprintf(stderr, "error: Process %d did not exit cleanly\n", int(pid));
+      abort();
+    }
+  }
+
+  report_timing(elapsed);
+}
+
+int main(int argc, char **argv)
+{
+  ShmemApp app(argc, argv);
+  app.execute_main_loop();
+  return 0;
+}
@@ -27,7 +27,11 @@ class SERtask_graph_t implements Serializable {
     private int radix;
     private int period;
     private double fraction_connected;
+    private int sweeps;
+    private double exponent;
     private long output_bytes_per_task;
+    private int output_distribution;
+    private long min_output_bytes_per_task;
     private long scratch_bytes_per_task; 
 
     public SERtask_graph_t(task_graph_t taskGraph) { 
@@ -42,7 +46,11 @@ class SERtask_graph_t implements Serializable {
         this.radix = taskGraph.getRadix();
         this.period = taskGraph.getPeriod();
         this.fraction_connected = taskGraph.getFraction_connected();
+        this.sweeps = taskGraph.getSweeps();
+        this.exponent = taskGraph.getExponent();
         this.output_bytes_per_task = taskGraph.getOutput_bytes_per_task();
+        this.output_distribution = taskGraph.getOutput_distribution().swigValue();
+        this.min_output_bytes_per_task = taskGraph.getMin_output_bytes_per_task();
         this.scratch_bytes_per_task = taskGraph.getScratch_bytes_per_task();
     }
 
@@ -61,7 +69,11 @@ class SERtask_graph_t implements Serializable {
         tg.setRadix(this.radix);
         tg.setPeriod(this.period);
         tg.setFraction_connected(this.fraction_connected);
+        tg.setSweeps(this.sweeps);
+        tg.setExponent(this.exponent);
         tg.setOutput_bytes_per_task(this.output_bytes_per_task);
+        tg.setOutput_distribution(output_distribution_t.swigToEnum(this.output_distribution));
+        tg.setMin_output_bytes_per_task(this.min_output_bytes_per_task);
         tg.setScratch_bytes_per_task(this.scratch_bytes_per_task);
         return tg;
     }
@@ -79,7 +91,11 @@ class SERtask_graph_t implements Serializable {
             " radix: " + radix +
             " period: " + period +
             " fraction_connected: " + fraction_connected +
+            " sweeps: " + sweeps +
+            " exponent: " + exponent +
             " output:" + Long.toString(output_bytes_per_task) +
+            " output_dist: " + output_distribution +
+            " output_min: " + Long.toString(min_output_bytes_per_task) +
             " scratch: " + Long.toString(scratch_bytes_per_task);
     }
 }
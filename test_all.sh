@@ -21,6 +21,17 @@ basic_types=(
     nearest
     "spread -period 2"
     random_nearest
+    v_cycle
+    w_cycle
+    wavefront
+    "wavefront -sweeps 4 -width 8"
+    "wavefront -sweeps 2 -width 16"
+    allreduce_butterfly
+    allreduce_tree
+    scan_hillis_steele
+    scan_work_efficient
+    "power_law -radix 9 -exponent 1.5"
+    "recursive -radix 2 -width 8"
 )
 extended_types=(
     "${basic_types[@]}"
@@ -39,6 +50,45 @@ steps=23 # chosen to be relatively prime with 2, 3, 5
 
 set -x
 
+for t in "${extended_types[@]}"; do
+    for k in "${kernels[@]}"; do
+        ./serial/main -steps $steps -type $t $k
+        ./serial/main -steps $steps -type $t $k -and -steps $steps -type $t $k
+        ./serial/main -steps $steps -type $t $k -order all -order-band 5 -order-tile 3
+    done
+done
+
+for t in "${extended_types[@]}"; do
+    for k in "${kernels[@]}"; do
+        for policy in central random locality; do
+            ./native/main -steps $steps -type $t $k -worker 2 -policy $policy
+            ./native/main -steps $steps -type $t $k -worker 2 -policy $policy -and -steps $steps -type $t $k
+        done
+        ./native/main -steps $steps -type $t $k -worker 2 -executor bulk_synchronous
+        ./native/main -steps $steps -type $t $k -worker 2 -executor bulk_synchronous -and -steps $steps -type $t $k
+        ./native/main -steps $steps -type $t $k -worker 2 -concurrent -and -steps $steps -type stencil_1d $k -width 8
+        ./native/main -steps $steps -type $t $k -worker 2 -executor bulk_synchronous -concurrent -and -steps $steps -type stencil_1d $k -width 8
+        ./native/main -steps $steps -type $t $k -worker 3 -elastic 0:1,2:3,5:2
+        for pin in none compact scatter core socket 0; do
+            ./native/main -steps $steps -type $t $k -worker 2 -pin $pin
+        done
+        ./native/main -steps $steps -type $t $k -worker 3 -elastic 1:2 -concurrent -and -steps $steps -type stencil_1d $k -width 8
+        ./native/main -steps $steps -type $t $k -worker 3 -executor bulk_synchronous -elastic 0:1,2:3,5:2
+        ./native/main -steps $steps -type $t $k -worker 3 -executor bulk_synchronous -elastic 1:2,3:1 -concurrent -and -steps $steps -type stencil_1d $k -width 8
+        ./native/main -steps $steps -type $t $k -worker 3 -elastic 1:2,4:1 -tenant -steps $steps -type stencil_1d $k -width 8
+        for tenant_policy in fair priority; do
+            ./native/main -steps $steps -type $t $k -worker 2 -tenant-policy $tenant_policy -tenant -steps $steps -type stencil_1d $k -width 8
+        done
+    done
+done
+
+for t in "${extended_types[@]}"; do
+    for k in "${kernels[@]}"; do
+        ./shmem/main -steps $steps -type $t $k -proc 2
+        ./shmem/main -steps $steps -type $t $k -proc 4 -latency 1 -and -steps $steps -type $t $k
+    done
+done
+
 if [[ $TASKBENCH_USE_MPI -eq 1 ]]; then
     for t in "${extended_types[@]}"; do
         for k in "${kernels[@]}"; do
@@ -233,6 +283,40 @@ if [[ $USE_OPENMP -eq 1 ]]; then
         for k in "${kernels[@]}"; do
             ./openmp/main -steps $steps -type $t $k -worker 2
             ./openmp/main -steps $steps -type $t $k -and -steps $steps -type $t $k -worker 2
+            ./openmp/main -steps $steps -type $t $k -worker 2 -generic-deps
+            ./openmp/main -steps $steps -type $t $k -worker 2 -pin scatter
+            ./openmp/main -steps $steps -type $t $k -worker 2 -window 2
+            ./openmp/main -steps $steps -type $t $k -worker 2 -concurrent -and -steps $steps -type stencil_1d $k -width 8
+            ./openmp/main -steps $steps -type $t $k -worker 2 -tenant-policy priority -tenant -steps $steps -type stencil_1d $k -width 8
+            for schedule in static dynamic guided; do
+                ./openmp/forall -steps $steps -type $t $k -worker 2 -schedule $schedule
+            done
+            ./openmp/forall -steps $steps -type $t $k -worker 2 -and -steps $steps -type $t $k
+            ./openmp/forall -steps $steps -type $t $k -worker 2 -nowait
+        done
+    done
+    # more inputs than the fixed-arity tasks take
+    ./openmp/main -steps $steps -type all_to_all -width 32 -worker 2
+    ./openmp/main -steps $steps -type nearest -radix 17 -width 32 -worker 2
+    # outputs that differ per point and per consumer
+    for dist in point edge; do
+        ./openmp/main -steps $steps -type nearest -radix 5 -width 32 -output 64 -output-dist $dist -worker 2
+        ./openmp/main -steps $steps -type all_to_all -width 32 -output 64 -output-dist $dist -worker 2
+        ./openmp/main_buffer -steps $steps -type nearest -radix 5 -output 64 -output-dist $dist -worker 2
+        ./openmp/main_buffer2 -steps $steps -type nearest -radix 5 -output 64 -output-dist $dist -worker 2
+        ./openmp/forall -steps $steps -type nearest -radix 5 -output 64 -output-dist $dist -worker 2
+        ./openmp/forall -steps $steps -type all_to_all -output 64 -output-dist $dist -worker 2 -nowait
+    done
+    # untied tasks sharing the scratch pool
+    ./openmp/main -steps $steps -type nearest -radix 5 -width 32 $memory_bound -worker 4
+fi
+
+if [[ $USE_COROUTINE -eq 1 ]]; then
+    for t in "${extended_types[@]}"; do
+        for k in "${kernels[@]}"; do
+            ./coroutine/main -steps $steps -type $t $k -worker 2
+            ./coroutine/main -steps $steps -type $t $k -worker 2 -overhead -and -steps $steps -type $t $k
+            ./coroutine/main -steps $steps -type $t $k -worker 3 -elastic 0:1,2:3,5:2 -and -steps $steps -type stencil_1d $k -width 8
         done
     done
 fi
@@ -0,0 +1,40 @@
+#!/bin/bash
+
+# Runs graphs of more than 2^31 tasks through the in-tree drivers to
+# catch 32-bit index arithmetic. Kernels are trivial and every driver
+# keeps only two ring-buffered fields, so memory stays small, but each
+# run still executes every task; this is why it is not part of
+# test_all.sh. Set WIDTH, STEPS and LONG_STEPS to try smaller graphs
+# first.
+
+set -e
+
+width=${WIDTH:-65536}
+steps=${STEPS:-32769} # 2^16 * (2^15 + 1) = 2^31 + 2^16 tasks
+long_steps=${LONG_STEPS:-2147483649} # more timesteps than int32_t holds
+workers=${WORKERS:-4} # must divide width * steps for kernel_bench
+
+graph="-steps $steps -width $width -type stencil_1d -field 2"
+long_graph="-steps $long_steps -width 1 -type stencil_1d -field 2"
+
+# Graphs whose indices do not fit must be rejected, not wrapped.
+expect_error() {
+    if "$@" 2> /dev/null > /dev/null; then
+        echo "expected an error from: $*"
+        false
+    fi
+}
+
+set -x
+
+expect_error ./serial/main -steps 140737488355329 -width 4
+expect_error ./serial/main -steps 4 -width 4611686018427387904
+
+./serial/main $graph
+./serial/main $long_graph
+./openmp/main $long_graph -worker $workers -window 4
+./openmp/forall $graph -worker $workers
+./openmp/forall $graph -worker $workers -nowait
+./openmp/main $graph -worker $workers -window 4
+./native/main $graph -worker $workers -executor bulk_synchronous
+./kernel_bench/main -steps $steps -width $width -type trivial -worker $workers